@@ -0,0 +1,179 @@
+#include "async_file_reader.h"
+
+#include <linux/io_uring.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <utility>
+
+// Declared like the wrappers of linux_syscall_support.h, so they return -errno the same way.
+LSS_INLINE _syscall2(int, io_uring_setup, unsigned int, entries, struct io_uring_params*, params)
+LSS_INLINE _syscall6(int, io_uring_enter, int, fd, unsigned int, to_submit, unsigned int, min_complete, unsigned int,
+                     flags, const void*, arg, size_t, argsz)
+LSS_INLINE _syscall4(int, io_uring_register, int, fd, unsigned int, opcode, void*, arg, unsigned int, nr_args)
+
+namespace io::internal {
+namespace {
+// Written by whichever reader first finds io_uring unusable; relaxed is enough for a hint.
+auto io_uring_unavailable_ = std::atomic<bool>{};
+
+// IORING_OP_READ and reads at the file position (offset -1) arrived in 5.6, together with the
+// probe itself. Older kernels set up a ring fine but fail every such read with -EINVAL.
+auto SupportsRead(int ring_fd) -> bool {
+  static constexpr unsigned kOps = IORING_OP_READ + 1;
+  alignas(io_uring_probe) uint8_t storage[sizeof(io_uring_probe) + kOps * sizeof(io_uring_probe_op)]{};
+  auto probe = reinterpret_cast<io_uring_probe*>(storage);
+  if (raw_io_uring_register(ring_fd, IORING_REGISTER_PROBE, probe, kOps) < 0) [[unlikely]] {
+    return false;
+  }
+  return probe->last_op >= IORING_OP_READ && (probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED);
+}
+
+auto MapRing(int ring_fd, size_t size, uint64_t offset) -> void* {
+  auto map = raw_mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+  if (reinterpret_cast<uintptr_t>(map) >= -4095UL) [[unlikely]] {
+    return nullptr;
+  }
+  return map;
+}
+
+template <typename T>
+auto RingField(void* ring, uint32_t offset) {
+  return reinterpret_cast<T*>(static_cast<uint8_t*>(ring) + offset);
+}
+}  // namespace
+
+void IoUring::SetUnavailable() { io_uring_unavailable_.store(true, std::memory_order_relaxed); }
+
+IoUring::IoUring(unsigned entries) {
+  if (io_uring_unavailable_.load(std::memory_order_relaxed)) [[unlikely]] {
+    return;
+  }
+
+  io_uring_params params{};
+  auto ring_fd = raw_io_uring_setup(entries, &params);
+  if (ring_fd < 0) [[unlikely]] {
+    // ENOSYS: Kernel built without io_uring.
+    // EPERM/EACCES: Disabled by sysctl or blocked by SELinux policies.
+    if (ring_fd == -ENOSYS || ring_fd == -EPERM || ring_fd == -EACCES) [[likely]] {
+      SetUnavailable();
+    }
+    return;
+  }
+  ring_fd_ = ring_fd;
+
+  if (!SupportsRead(ring_fd_)) [[unlikely]] {
+    SetUnavailable();
+    Release();
+    return;
+  }
+
+  sq_ring_size_ = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+  cq_ring_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    sq_ring_size_ = cq_ring_size_ = std::max(sq_ring_size_, cq_ring_size_);
+  }
+
+  sq_ring_ = MapRing(ring_fd_, sq_ring_size_, IORING_OFF_SQ_RING);
+  if (params.features & IORING_FEAT_SINGLE_MMAP) {
+    cq_ring_ = sq_ring_;
+  } else if (sq_ring_) {
+    cq_ring_ = MapRing(ring_fd_, cq_ring_size_, IORING_OFF_CQ_RING);
+  }
+  sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  if (cq_ring_) sqes_ = MapRing(ring_fd_, sqes_size_, IORING_OFF_SQES);
+
+  if (!sq_ring_ || !cq_ring_ || !sqes_) [[unlikely]] {
+    Release();
+    return;
+  }
+
+  sq_head_ = RingField<uint32_t>(sq_ring_, params.sq_off.head);
+  sq_tail_ = RingField<uint32_t>(sq_ring_, params.sq_off.tail);
+  sq_mask_ = *RingField<uint32_t>(sq_ring_, params.sq_off.ring_mask);
+  sq_array_ = RingField<uint32_t>(sq_ring_, params.sq_off.array);
+  cq_head_ = RingField<uint32_t>(cq_ring_, params.cq_off.head);
+  cq_tail_ = RingField<uint32_t>(cq_ring_, params.cq_off.tail);
+  cq_mask_ = *RingField<uint32_t>(cq_ring_, params.cq_off.ring_mask);
+  cqes_ = RingField<void>(cq_ring_, params.cq_off.cqes);
+}
+
+auto IoUring::operator=(IoUring&& other) noexcept -> IoUring& {
+  if (this != &other) {
+    Release();
+    ring_fd_ = std::exchange(other.ring_fd_, -1);
+    sq_ring_ = std::exchange(other.sq_ring_, nullptr);
+    sq_ring_size_ = other.sq_ring_size_;
+    cq_ring_ = std::exchange(other.cq_ring_, nullptr);
+    cq_ring_size_ = other.cq_ring_size_;
+    sqes_ = std::exchange(other.sqes_, nullptr);
+    sqes_size_ = other.sqes_size_;
+    sq_head_ = other.sq_head_;
+    sq_tail_ = other.sq_tail_;
+    sq_mask_ = other.sq_mask_;
+    sq_array_ = other.sq_array_;
+    cq_head_ = other.cq_head_;
+    cq_tail_ = other.cq_tail_;
+    cq_mask_ = other.cq_mask_;
+    cqes_ = other.cqes_;
+  }
+  return *this;
+}
+
+void IoUring::Release() {
+  if (sqes_) raw_munmap(std::exchange(sqes_, nullptr), sqes_size_);
+  if (cq_ring_ && cq_ring_ != sq_ring_) raw_munmap(cq_ring_, cq_ring_size_);
+  cq_ring_ = nullptr;
+  if (sq_ring_) raw_munmap(std::exchange(sq_ring_, nullptr), sq_ring_size_);
+  if (ring_fd_ >= 0) raw_close(std::exchange(ring_fd_, -1));
+}
+
+auto IoUring::SubmitRead(int fd, void* buf, uint32_t len, int64_t offset, uint64_t user_data) -> bool {
+  auto tail = *sq_tail_;
+  if (tail - __atomic_load_n(sq_head_, __ATOMIC_ACQUIRE) > sq_mask_) [[unlikely]] {
+    return false;
+  }
+
+  auto index = tail & sq_mask_;
+  auto sqe = static_cast<io_uring_sqe*>(sqes_) + index;
+  *sqe = io_uring_sqe{};
+  sqe->opcode = IORING_OP_READ;
+  sqe->fd = fd;
+  sqe->off = static_cast<uint64_t>(offset);
+  sqe->addr = reinterpret_cast<uintptr_t>(buf);
+  sqe->len = len;
+  sqe->user_data = user_data;
+  sq_array_[index] = index;
+  __atomic_store_n(sq_tail_, tail + 1, __ATOMIC_RELEASE);
+
+  int r;
+  do {
+    r = raw_io_uring_enter(ring_fd_, 1, 0, 0, nullptr, 0);
+  } while (r == -EINTR);
+  if (r != 1) [[unlikely]] {
+    // Nothing was consumed; take the entry back so the ring stays consistent.
+    __atomic_store_n(sq_tail_, tail, __ATOMIC_RELEASE);
+    return false;
+  }
+  return true;
+}
+
+auto IoUring::WaitCompletion(uint64_t* user_data) -> int32_t {
+  for (;;) {
+    auto head = *cq_head_;
+    if (head != __atomic_load_n(cq_tail_, __ATOMIC_ACQUIRE)) [[likely]] {
+      auto cqe = static_cast<io_uring_cqe*>(cqes_) + (head & cq_mask_);
+      *user_data = cqe->user_data;
+      auto res = cqe->res;
+      __atomic_store_n(cq_head_, head + 1, __ATOMIC_RELEASE);
+      return res;
+    }
+
+    auto r = raw_io_uring_enter(ring_fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+    if (r < 0 && r != -EINTR) [[unlikely]] {
+      return r;
+    }
+  }
+}
+}  // namespace io::internal
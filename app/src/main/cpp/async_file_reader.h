@@ -0,0 +1,244 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include "file_reader.h"
+
+namespace io {
+namespace internal {
+/**
+ * Minimal io_uring wrapper driven directly through the raw syscalls, sized for a handful of
+ * in-flight reads. An instance that failed to set up is simply invalid; once the kernel (or
+ * SELinux) refuses io_uring_setup, or the kernel predates IORING_OP_READ (5.6), later instances do
+ * not try again.
+ */
+class IoUring {
+ public:
+  IoUring() = default;
+
+  explicit IoUring(unsigned entries);
+
+  IoUring(IoUring&& other) noexcept { *this = std::move(other); }
+
+  auto operator=(IoUring&& other) noexcept -> IoUring&;
+
+  IoUring(const IoUring&) = delete;
+  void operator=(const IoUring&) = delete;
+
+  ~IoUring() { Release(); }
+
+  [[nodiscard]] auto IsValid() const noexcept { return ring_fd_ >= 0; }
+
+  // Stops later instances from setting up a ring, after the kernel turned out not to support it.
+  static void SetUnavailable();
+
+  // Queues and submits a read of `len` bytes at `offset` (-1 reads at the file position).
+  auto SubmitRead(int fd, void* buf, uint32_t len, int64_t offset, uint64_t user_data) -> bool;
+
+  // Blocks until a completion is available and returns its result (bytes read or -errno).
+  auto WaitCompletion(uint64_t* user_data) -> int32_t;
+
+ private:
+  void Release();
+
+  int ring_fd_{-1};
+  void* sq_ring_{};
+  size_t sq_ring_size_{};
+  void* cq_ring_{};
+  size_t cq_ring_size_{};
+  void* sqes_{};
+  size_t sqes_size_{};
+
+  uint32_t* sq_head_{};
+  uint32_t* sq_tail_{};
+  uint32_t sq_mask_{};
+  uint32_t* sq_array_{};
+  uint32_t* cq_head_{};
+  uint32_t* cq_tail_{};
+  uint32_t cq_mask_{};
+  void* cqes_{};
+};
+}  // namespace internal
+
+/**
+ * @brief A double-buffered FileReader that overlaps parsing with I/O through io_uring.
+ *
+ * The buffer is split into two halves: while lines are being cut out of one half, the next
+ * chunk of the file is already being read into the other. A partial line at the end of a half
+ * is copied into a carry area placed right before the next half, so every line is returned as
+ * one contiguous view. When io_uring is unavailable (old kernels, seccomp or SELinux denial) the
+ * halves are filled synchronously with raw_read and the reader behaves like FileReader.
+ *
+ * @tparam Buffer Size of the two halves together; the allocation is twice as large to make room
+ * for the carry areas.
+ * @tparam kDelimiter Same as FileReader.
+ *
+ * @code
+ * for (auto line : AsyncFileReader<>{"/data/local/tmp/maps.txt"}) {}
+ * @endcode
+ *
+ * @note Lines longer than half the buffer are returned in pieces, as FileReader does on a full buffer.
+ * Reads are positioned, so the file offset of a borrowed `fd` is left untouched.
+ * @warning The reader cannot be moved: a read may be in flight into its buffer.
+ */
+template <internal::BufferPolicy Buffer = DefaultHeapBuffer, internal::FixedString kDelimiter = UTF8::LF>
+  requires(Buffer::size % (2 * sizeof(void*)) == 0)
+class AsyncFileReader {
+ public:
+  using char_type = decltype(kDelimiter)::value_type;
+  using string_view_type = std::basic_string_view<char_type>;
+  using value_type = string_view_type;
+  using iterator = internal::Iterator<AsyncFileReader>;
+
+  explicit AsyncFileReader(int fd) : AsyncFileReader{fd, false} {}
+
+  explicit AsyncFileReader(const char* pathname) : AsyncFileReader{raw_open(pathname, O_RDONLY | O_CLOEXEC), true} {}
+
+  AsyncFileReader(int dirfd, const char* pathname)
+      : AsyncFileReader{raw_openat(dirfd, pathname, O_RDONLY | O_CLOEXEC), true} {}
+
+  AsyncFileReader(const AsyncFileReader&) = delete;
+  void operator=(const AsyncFileReader&) = delete;
+
+  ~AsyncFileReader() {
+    if (in_flight_) Await(in_flight_half_);
+    if (fd_ >= 0 && owned_) raw_close(fd_);
+  }
+
+  operator bool() const noexcept { return IsValid(); }
+
+  auto operator++() { return NextLine(); }
+  auto operator++(int) { return NextLine(); }
+
+  [[nodiscard]] auto IsValid() const noexcept { return fd_ >= 0; }
+  [[nodiscard]] auto IsAsync() const noexcept { return ring_.IsValid(); }
+  [[nodiscard]] auto GetFd() const noexcept { return fd_; }
+
+  [[nodiscard]] auto begin() { return iterator{this}; }
+  [[nodiscard]] auto end() { return iterator{}; }
+
+  auto NextLine() -> std::optional<string_view_type> {
+    if (eof_ || fd_ < 0) [[unlikely]] {
+      return {};
+    }
+
+    for (;;) {
+      if (auto res = Splitter::Split(&buffer_[pos_], end_ - pos_, scanned_)) [[likely]] {
+        pos_ += res->second;
+        scanned_ = 0;
+        return res->first;
+      }
+
+      auto rem = end_ - pos_;
+      if (rem > kCarrySize) [[unlikely]] {
+        scanned_ = 0;
+        auto line = string_view_type{reinterpret_cast<const char_type*>(&buffer_[pos_]), rem / sizeof(char_type)};
+        pos_ += internal::AlignDown<char_type>(rem);
+        return line;
+      }
+
+      auto next = current_ ^ 1;
+      auto n = Await(next);
+      if (n <= 0) [[unlikely]] {
+        eof_ = true;
+        return Splitter::Tail(&buffer_[pos_], rem);
+      }
+
+      // The old half is released here: its unconsumed tail moves into the carry area of the new
+      // half, and every view handed out from it has been invalidated by this call.
+      auto start = HalfOffset(next);
+      memcpy(&buffer_[start - rem], &buffer_[pos_], rem);
+      pos_ = start - rem;
+      end_ = start + static_cast<size_t>(n);
+      current_ = next;
+      Submit(next ^ 1);
+    }
+  }
+
+ private:
+  using Splitter = internal::LineSplitter<kDelimiter>;
+
+  static constexpr size_t kHalfSize = Buffer::size / 2;
+  static constexpr size_t kCarrySize = kHalfSize;
+  // Layout: [carry 0][half 0][carry 1][half 1][reserved]
+  static constexpr size_t kSlotSize = kCarrySize + kHalfSize;
+  static constexpr size_t kAllocSize = kSlotSize * 2 + sizeof(void*);
+
+  static constexpr auto HalfOffset(int half) -> size_t { return static_cast<size_t>(half) * kSlotSize + kCarrySize; }
+
+  AsyncFileReader(int fd, bool owned)
+      : fd_{fd}, owned_{owned}, buffer_{Buffer::template make_buffer<kAllocSize>()} {
+    if (fd_ < 0) [[unlikely]] {
+      return;
+    }
+    // Streams (pipes, sockets) have no offset and are read at the file position instead.
+    offset_ = raw_lseek(fd_, 0, SEEK_CUR);
+    if (offset_ < 0) offset_ = -1;
+    ring_ = internal::IoUring{2};
+    pos_ = end_ = HalfOffset(current_);
+    Submit(current_ ^ 1);
+  }
+
+  void Submit(int half) {
+    if (ring_.IsValid() && ring_.SubmitRead(fd_, &buffer_[HalfOffset(half)], kHalfSize, offset_, half)) [[likely]] {
+      in_flight_ = true;
+      in_flight_half_ = half;
+      return;
+    }
+    ready_[half] = ReadSync(half);
+  }
+
+  auto Await(int half) -> ssize_t {
+    ssize_t n;
+    if (in_flight_ && in_flight_half_ == half) {
+      uint64_t user_data;
+      n = ring_.WaitCompletion(&user_data);
+      in_flight_ = false;
+      // Interrupted or short on resources: finish this chunk synchronously.
+      if (n == -EINTR || n == -EAGAIN) [[unlikely]] {
+        n = ReadSync(half);
+      } else if (n == -EINVAL || n == -EOPNOTSUPP) [[unlikely]] {
+        // The kernel took the ring but not the read; continue without io_uring. A real error of
+        // the file is reported again by the synchronous read.
+        internal::IoUring::SetUnavailable();
+        ring_ = {};
+        n = ReadSync(half);
+      }
+    } else {
+      n = ready_[half];
+    }
+    if (n > 0 && offset_ >= 0) offset_ += n;
+    return n;
+  }
+
+  auto ReadSync(int half) -> ssize_t {
+    ssize_t n;
+    do {
+      if (offset_ >= 0) {
+        n = raw_pread64(fd_, &buffer_[HalfOffset(half)], kHalfSize, offset_);
+      } else {
+        n = raw_read(fd_, &buffer_[HalfOffset(half)], kHalfSize);
+      }
+    } while (n == -EINTR);
+    return n;
+  }
+
+  int fd_;
+  bool owned_;
+  bool eof_{};
+  bool in_flight_{};
+  int in_flight_half_{};
+  int current_{1};
+  int64_t offset_{-1};
+  size_t pos_{};
+  size_t end_{};
+  size_t scanned_{};
+  ssize_t ready_[2]{};
+  internal::IoUring ring_;
+  Buffer::template type<kAllocSize> buffer_;
+};
+}  // namespace io
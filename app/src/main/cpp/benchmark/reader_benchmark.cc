@@ -0,0 +1,664 @@
+// Host benchmark of FileReader and DirReader under the buffer policies, against the usual libc and
+// C++ library ways of doing the same.
+//
+// Synthetic inputs are generated once into the work directory and reused by later runs. Every
+// contender runs kRepeats times over a warm page cache and the fastest run is reported:
+//   records  lines or entries seen (lines longer than a small buffer come out in pieces)
+//   Mrec/s   records per second
+//   MiB/s    input bytes per second
+//   reads    read/getdents64 calls made by the reader, from CountingStats
+//   syscalls every syscall of the run, open and close included (raw_syscalls tracepoint)
+//   cyc/rec  CPU cycles per record (perf_event_open, user + kernel when allowed)
+// Columns the host does not support are shown as "-".
+//
+// A table of readers fed by a source that returns a few hundred bytes per read, as pipes and some
+// procfs files do, over lines up to several times the buffer size: a line that spans many refills
+// is searched once with the scan cursor, and once per refill without it.
+//
+// A table of the delimiter search kernels alone compares them with memchr and memmem over lines of
+// a few bytes to several KiB held in memory, with no I/O in the way.
+//
+// A last table measures short-lived readers, created to read one buffer's worth of input and
+// destroyed: the page faults each one takes (getrusage) and its total time.
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "delimiter_search.h"
+#include "file_reader.h"
+
+namespace {
+using namespace io;
+
+constexpr int kRepeats = 5;
+
+// What one pass over an input saw, to compare the contenders with each other.
+struct Sample {
+  uint64_t records;
+  uint64_t bytes;
+};
+
+// A hardware or tracepoint counter of the calling thread.
+class PerfCounter {
+ public:
+  enum class Kind { kCycles, kSyscalls };
+
+  explicit PerfCounter(Kind kind) {
+    if (kind == Kind::kCycles) {
+      // Kernel cycles are what a syscall-heavy reader pays for, but they may be off limits.
+      for (auto exclude_kernel : {false, true}) {
+        if (Open(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, exclude_kernel)) break;
+      }
+    } else if (auto id = TracepointId("raw_syscalls/sys_enter")) {
+      Open(PERF_TYPE_TRACEPOINT, *id, false);
+    }
+  }
+
+  PerfCounter(const PerfCounter&) = delete;
+  void operator=(const PerfCounter&) = delete;
+
+  ~PerfCounter() {
+    if (fd_ >= 0) close(fd_);
+  }
+
+  [[nodiscard]] auto IsValid() const { return fd_ >= 0; }
+
+  void Start() {
+    if (fd_ < 0) return;
+    ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+    ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+  }
+
+  auto Stop() -> std::optional<uint64_t> {
+    if (fd_ < 0) return {};
+    ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+    uint64_t value;
+    if (read(fd_, &value, sizeof(value)) != sizeof(value)) return {};
+    return value;
+  }
+
+ private:
+  auto Open(uint32_t type, uint64_t config, bool exclude_kernel) -> bool {
+    perf_event_attr attr{};
+    attr.size = sizeof(attr);
+    attr.type = type;
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = exclude_kernel;
+    attr.exclude_hv = 1;
+    fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, PERF_FLAG_FD_CLOEXEC));
+    return fd_ >= 0;
+  }
+
+  static auto TracepointId(const char* event) -> std::optional<uint64_t> {
+    for (auto root : {"/sys/kernel/tracing/events", "/sys/kernel/debug/tracing/events"}) {
+      auto path = std::string{root} + "/" + event + "/id";
+      if (auto file = fopen(path.c_str(), "re")) {
+        uint64_t id;
+        auto ok = fscanf(file, "%" SCNu64, &id) == 1;
+        fclose(file);
+        if (ok) return id;
+      }
+    }
+    return {};
+  }
+
+  int fd_ = -1;
+};
+
+using RunFunc = auto (*)(const char* path) -> Sample;
+using ReadsFunc = auto (*)(const char* path) -> uint64_t;
+
+struct Contender {
+  std::string name;
+  RunFunc run;
+  // Only for the readers of this library.
+  ReadsFunc reads;
+};
+
+struct Bench {
+  PerfCounter cycles{PerfCounter::Kind::kCycles};
+  PerfCounter syscalls{PerfCounter::Kind::kSyscalls};
+
+  void Run(const char* title, const char* path, const std::vector<Contender>& contenders) {
+    auto input_size = InputSize(path);
+    printf("\n%s: %s, %.1f MiB\n", title, path, static_cast<double>(input_size) / (1 << 20));
+    printf("  %-40s %10s %9s %9s %8s %9s %8s\n", "contender", "records", "Mrec/s", "MiB/s", "reads", "syscalls",
+           "cyc/rec");
+
+    for (auto& contender : contenders) {
+      contender.run(path);  // Warm up the page cache and the allocator.
+
+      auto best = std::chrono::nanoseconds::max();
+      Sample sample{};
+      std::optional<uint64_t> best_cycles;
+      for (int i = 0; i < kRepeats; ++i) {
+        cycles.Start();
+        auto start = std::chrono::steady_clock::now();
+        sample = contender.run(path);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        auto run_cycles = cycles.Stop();
+        if (elapsed < best) {
+          best = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed);
+          best_cycles = run_cycles;
+        }
+      }
+
+      // Counted on a separate run, so the tracepoint does not slow down the timed ones.
+      syscalls.Start();
+      contender.run(path);
+      auto run_syscalls = syscalls.Stop();
+      if (run_syscalls) --*run_syscalls;  // The PERF_EVENT_IOC_DISABLE ioctl.
+
+      auto seconds = std::chrono::duration<double>(best).count();
+      auto records = static_cast<double>(sample.records);
+      printf("  %-40s %10" PRIu64 " %9.2f %9.1f %8s %9s %8s\n", contender.name.c_str(), sample.records,
+             records / seconds / 1e6, static_cast<double>(input_size) / seconds / (1 << 20),
+             contender.reads ? Format(contender.reads(path)).c_str() : "-", Format(run_syscalls).c_str(),
+             best_cycles && sample.records ? Format(*best_cycles / sample.records).c_str() : "-");
+    }
+  }
+
+  static auto InputSize(const char* path) -> uint64_t {
+    struct stat st;
+    if (stat(path, &st) != 0) return 0;
+    if (S_ISREG(st.st_mode)) return static_cast<uint64_t>(st.st_size);
+    // A directory: the size of the records getdents64 returns.
+    uint64_t size = 0;
+    for (auto entry : DirReader<>{path}) size += entry.entry->d_reclen;
+    return size;
+  }
+
+  static auto Format(std::optional<uint64_t> value) -> std::string {
+    return value ? std::to_string(*value) : std::string{"-"};
+  }
+};
+
+// Readers of this library
+
+template <typename Reader>
+auto ReadLines(const char* path) -> Sample {
+  Sample sample{};
+  for (auto line : Reader{path}) {
+    ++sample.records;
+    sample.bytes += line.size() * sizeof(line[0]);
+  }
+  return sample;
+}
+
+template <typename Reader>
+auto CountLineReads(const char* path) -> uint64_t {
+  auto reader = Reader{path};
+  for ([[maybe_unused]] auto line : reader) {
+  }
+  return reader.GetStats().syscalls;
+}
+
+template <typename Reader>
+auto ReadEntries(const char* path) -> Sample {
+  Sample sample{};
+  for (auto entry : Reader{path}) {
+    ++sample.records;
+    sample.bytes += entry.name().size();
+  }
+  return sample;
+}
+
+template <typename Reader>
+auto CountEntryReads(const char* path) -> uint64_t {
+  auto reader = Reader{path};
+  for ([[maybe_unused]] auto entry : reader) {
+  }
+  return reader.GetStats().syscalls;
+}
+
+template <internal::BufferPolicy Buffer, internal::FixedString kDelimiter>
+void AddFileReader(std::vector<Contender>& out, const char* buffer_name) {
+  out.push_back({
+      .name = std::string{"FileReader<"} + buffer_name + ">",
+      .run = ReadLines<FileReader<Buffer, kDelimiter>>,
+      .reads = CountLineReads<FileReader<Buffer, kDelimiter, CountingStats>>,
+  });
+}
+
+template <internal::FixedString kDelimiter>
+void AddFileReaders(std::vector<Contender>& out) {
+  AddFileReader<StackBuffer<4 * 1024>, kDelimiter>(out, "StackBuffer<4K>");
+  AddFileReader<StackBuffer<16 * 1024>, kDelimiter>(out, "StackBuffer<16K>");
+  AddFileReader<StackBuffer<64 * 1024>, kDelimiter>(out, "StackBuffer<64K>");
+  AddFileReader<HeapBuffer<4 * 1024>, kDelimiter>(out, "HeapBuffer<4K>");
+  AddFileReader<HeapBuffer<64 * 1024>, kDelimiter>(out, "HeapBuffer<64K>");
+  AddFileReader<HeapBuffer<1024 * 1024>, kDelimiter>(out, "HeapBuffer<1M>");
+  AddFileReader<MMapBuffer<64 * 1024>, kDelimiter>(out, "MMapBuffer<64K>");
+  AddFileReader<MMapBuffer<1024 * 1024>, kDelimiter>(out, "MMapBuffer<1M>");
+  // Reads from the device on every run, bypassing the warm page cache the others use.
+  AddFileReader<AlignedDirectBuffer<1024 * 1024>, kDelimiter>(out, "AlignedDirectBuffer<1M>");
+}
+
+template <internal::BufferPolicy Buffer>
+void AddDirReader(std::vector<Contender>& out, const char* buffer_name) {
+  out.push_back({
+      .name = std::string{"DirReader<"} + buffer_name + ">",
+      .run = ReadEntries<DirReader<Buffer>>,
+      .reads = CountEntryReads<DirReader<Buffer, CountingStats>>,
+  });
+}
+
+// Baselines
+
+template <bool kStripCR>
+auto GetlineLines(const char* path) -> Sample {
+  Sample sample{};
+  auto in = std::ifstream{path, std::ios::binary};
+  std::string line;
+  while (std::getline(in, line)) {
+    auto size = line.size();
+    if (kStripCR && size > 0 && line[size - 1] == '\r') --size;
+    ++sample.records;
+    sample.bytes += size;
+  }
+  return sample;
+}
+
+template <bool kStripCR>
+auto FgetsLines(const char* path) -> Sample {
+  Sample sample{};
+  auto file = fopen(path, "re");
+  if (!file) return sample;
+  static char line[64 * 1024];
+  while (fgets(line, sizeof(line), file)) {
+    auto size = strlen(line);
+    // A line longer than the buffer comes in pieces, as with a small FileReader buffer.
+    if (size > 0 && line[size - 1] == '\n') --size;
+    if (kStripCR && size > 0 && line[size - 1] == '\r') --size;
+    ++sample.records;
+    sample.bytes += size;
+  }
+  fclose(file);
+  return sample;
+}
+
+// There is no getline for raw UTF-16, so chunks are scanned by hand.
+auto FreadLines16(const char* path) -> Sample {
+  Sample sample{};
+  auto file = fopen(path, "re");
+  if (!file) return sample;
+  static char16_t buffer[32 * 1024];
+  size_t carry = 0;
+  for (;;) {
+    auto n = fread(buffer + carry, sizeof(char16_t), std::size(buffer) - carry, file);
+    if (n == 0) break;
+    auto chunk = std::u16string_view{buffer, carry + n};
+    size_t pos = 0;
+    for (size_t end; (end = chunk.find(u'\n', pos)) != chunk.npos; pos = end + 1) {
+      ++sample.records;
+      sample.bytes += (end - pos) * sizeof(char16_t);
+    }
+    if (pos == 0 && chunk.size() == std::size(buffer)) {
+      ++sample.records;
+      sample.bytes += sizeof(buffer);
+      pos = chunk.size();
+    }
+    carry = chunk.size() - pos;
+    std::char_traits<char16_t>::move(buffer, buffer + pos, carry);
+  }
+  if (carry > 0) {
+    ++sample.records;
+    sample.bytes += carry * sizeof(char16_t);
+  }
+  fclose(file);
+  return sample;
+}
+
+auto ReaddirEntries(const char* path) -> Sample {
+  Sample sample{};
+  auto dir = opendir(path);
+  if (!dir) return sample;
+  while (auto entry = readdir(dir)) {
+    ++sample.records;
+    sample.bytes += strlen(entry->d_name);
+  }
+  closedir(dir);
+  return sample;
+}
+
+// Skips "." and "..", which the others return.
+auto DirectoryIteratorEntries(const char* path) -> Sample {
+  Sample sample{};
+  std::error_code ec;
+  for (auto it = std::filesystem::directory_iterator{path, ec}; !ec && it != std::filesystem::directory_iterator{};
+       it.increment(ec)) {
+    ++sample.records;
+    sample.bytes += it->path().filename().native().size();
+  }
+  return sample;
+}
+
+// Short-lived readers
+
+template <internal::BufferPolicy Buffer>
+void RunSetup(const char* path, const char* buffer_name) {
+  constexpr int kReaders = 100;
+  uint64_t sink = 0;
+  rusage before, after;
+  getrusage(RUSAGE_THREAD, &before);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < kReaders; ++i) {
+    for (auto line : FileReader<Buffer>{path}) sink += line.size();
+  }
+  auto elapsed = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+  getrusage(RUSAGE_THREAD, &after);
+  auto faults = (after.ru_minflt - before.ru_minflt) + (after.ru_majflt - before.ru_majflt);
+  printf("  %-40s %10" PRIu64 " %9.1f %9.1f\n", (std::string{"FileReader<"} + buffer_name + ">").c_str(), sink / kReaders,
+         static_cast<double>(faults) / kReaders, elapsed / kReaders);
+}
+
+void RunSetups(const char* small_input, const char* large_input) {
+  printf("\nshort-lived readers (64 KiB: %s, 4 MiB: %s)\n", small_input, large_input);
+  printf("  %-40s %10s %9s %9s\n", "contender", "bytes", "faults", "us");
+  RunSetup<StackBuffer<64 * 1024>>(small_input, "StackBuffer<64K>");
+  RunSetup<HeapBuffer<64 * 1024>>(small_input, "HeapBuffer<64K>");
+  RunSetup<MMapBuffer<64 * 1024>>(small_input, "MMapBuffer<64K>");
+  RunSetup<PrefaultedMMapBuffer<64 * 1024>>(small_input, "PrefaultedMMapBuffer<64K>");
+  RunSetup<HeapBuffer<4 * 1024 * 1024>>(large_input, "HeapBuffer<4M>");
+  RunSetup<MMapBuffer<4 * 1024 * 1024>>(large_input, "MMapBuffer<4M>");
+  RunSetup<PrefaultedMMapBuffer<4 * 1024 * 1024>>(large_input, "PrefaultedMMapBuffer<4M>");
+}
+
+// Inputs
+
+constexpr std::string_view kAlphabet = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 ";
+// Some code units outside ASCII, one of them with a 0x0a low byte.
+constexpr std::u16string_view kAlphabet16 = u"abcdefghijklmnopqrstuvwxyz0123456789 é中Ċあ";
+
+auto Exists(const std::string& path) {
+  struct stat st;
+  return stat(path.c_str(), &st) == 0;
+}
+
+// Lines of [min_length, max_length] code units ending with `newline`, up to `size` bytes.
+template <typename CharT>
+auto WriteLines(const std::string& path, uint64_t size, size_t min_length, size_t max_length,
+                std::basic_string_view<CharT> alphabet, std::basic_string_view<CharT> newline) -> bool {
+  if (Exists(path)) return true;
+  auto tmp = path + ".tmp";
+  auto file = fopen(tmp.c_str(), "we");
+  if (!file) return false;
+  auto random = std::mt19937_64{size ^ min_length ^ max_length};
+  auto length = std::uniform_int_distribution<size_t>{min_length, max_length};
+  auto pick = std::uniform_int_distribution<size_t>{0, alphabet.size() - 1};
+  std::basic_string<CharT> line;
+  for (uint64_t written = 0; written < size; written += line.size() * sizeof(CharT)) {
+    line.resize(length(random));
+    for (auto& c : line) c = alphabet[pick(random)];
+    line += newline;
+    fwrite(line.data(), sizeof(CharT), line.size(), file);
+  }
+  auto ok = fclose(file) == 0;
+  return ok && rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+auto MakeDirectory(const std::string& path, size_t entries) -> bool {
+  if (Exists(path)) return true;
+  auto tmp = path + ".tmp";
+  std::error_code ec;
+  std::filesystem::remove_all(tmp, ec);
+  if (mkdir(tmp.c_str(), 0755) != 0) return false;
+  auto dirfd = open(tmp.c_str(), O_DIRECTORY | O_CLOEXEC);
+  if (dirfd < 0) return false;
+  char name[32];
+  for (size_t i = 0; i < entries; ++i) {
+    snprintf(name, sizeof(name), "entry-%07zu", i);
+    auto fd = openat(dirfd, name, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    if (fd < 0) {
+      close(dirfd);
+      return false;
+    }
+    close(fd);
+  }
+  close(dirfd);
+  return rename(tmp.c_str(), path.c_str()) == 0;
+}
+// Chunk-limited source
+
+// A CRLF FileReader whose reads return at most kChunk bytes. Without kResume the pending line is
+// searched again from its start after every refill, as before the scan cursor.
+template <bool kResume, size_t kChunk, internal::BufferPolicy Buffer = HeapBuffer<16 * 1024>>
+class ChunkedReader
+    : public internal::BaseReader<ChunkedReader<kResume, kChunk, Buffer>, std::string_view, Buffer, NoStats> {
+ public:
+  explicit ChunkedReader(const char* pathname)
+      : ChunkedReader::BaseReader{raw_open(pathname, O_RDONLY | O_CLOEXEC), true} {}
+
+  auto operator++() { return NextLine(); }
+
+  auto NextLine() -> std::optional<std::string_view> {
+    if constexpr (kResume) {
+      return this->NextImpl([] [[gnu::always_inline]] (const uint8_t* buf, size_t available, size_t& scanned) {
+        return Splitter::Split(buf, available, scanned);
+      });
+    } else {
+      return this->NextImpl([] [[gnu::always_inline]] (const uint8_t* buf, size_t available) {
+        return Splitter::Split(buf, available);
+      });
+    }
+  }
+
+ private:
+  using Splitter = internal::LineSplitter<UTF8::CRLF>;
+
+  static auto OnBufferFull(const uint8_t* buf, size_t size) -> std::optional<std::string_view> {
+    return std::string_view{reinterpret_cast<const char*>(buf), size};
+  }
+
+  static auto OnEOF(const uint8_t* buf, size_t size) -> std::optional<std::string_view> {
+    return Splitter::Tail(buf, size);
+  }
+
+  static auto ReadFromFD(int fd, void* buf, size_t size) -> ssize_t {
+    return raw_read(fd, buf, std::min(size, kChunk));
+  }
+
+  friend class ChunkedReader::BaseReader;
+};
+
+template <bool kResume, size_t kChunk>
+auto TimeChunked(const char* path) -> std::pair<Sample, double> {
+  auto best = std::chrono::nanoseconds::max();
+  Sample sample{};
+  for (int i = 0; i < kRepeats; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    sample = ReadLines<ChunkedReader<kResume, kChunk>>(path);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    best = std::min(best, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed));
+  }
+  return {sample, std::chrono::duration<double, std::milli>(best).count()};
+}
+
+template <size_t kChunk>
+void RunChunked(const char* path, size_t length) {
+  auto [resumed, resumed_ms] = TimeChunked<true, kChunk>(path);
+  auto [rescanned, rescanned_ms] = TimeChunked<false, kChunk>(path);
+  printf("  %10zu %8zu %10" PRIu64 " %12.1f %12.1f\n", length, kChunk, resumed.records, resumed_ms, rescanned_ms);
+  if (resumed.records != rescanned.records || resumed.bytes != rescanned.bytes) {
+    printf("  (the two readers saw different lines)\n");
+  }
+}
+
+void RunChunkedSources(const std::vector<std::pair<std::string, size_t>>& inputs) {
+  printf("\nchunk-limited source, CRLF, HeapBuffer<16K>, ms\n");
+  printf("  %10s %8s %10s %12s %12s\n", "line bytes", "chunk", "records", "scan cursor", "full rescan");
+  for (auto& [path, length] : inputs) {
+    RunChunked<512>(path.c_str(), length);
+    RunChunked<4096>(path.c_str(), length);
+  }
+}
+
+// Delimiter search
+
+// Lines of exactly `length` bytes followed by `newline`, up to `size` bytes in all.
+auto MakeLines(size_t size, size_t length, std::string_view newline) -> std::string {
+  auto random = std::mt19937_64{length};
+  auto pick = std::uniform_int_distribution<size_t>{0, kAlphabet.size() - 1};
+  std::string text;
+  text.reserve(size + length + newline.size());
+  while (text.size() < size) {
+    for (size_t i = 0; i < length; ++i) text += kAlphabet[pick(random)];
+    text += newline;
+  }
+  return text;
+}
+
+// Splits `text` with `kFind`, resuming after each delimiter as LineSplitter does.
+template <auto kFind, size_t kDelimiterSize>
+auto SearchLines(std::string_view text) -> Sample {
+  Sample sample{};
+  for (auto p = text.data(), end = p + text.size(); p < end;) {
+    auto next = kFind(p, static_cast<size_t>(end - p));
+    if (!next) break;
+    ++sample.records;
+    sample.bytes += static_cast<uint64_t>(next - p);
+    p = next + kDelimiterSize;
+  }
+  return sample;
+}
+
+constexpr auto kMemchrLF = [](const char* p, size_t n) { return static_cast<const char*>(memchr(p, '\n', n)); };
+constexpr auto kFindAnyOfLF = [](const char* p, size_t n) { return internal::FindAnyOf<char, '\n'>(p, n); };
+constexpr auto kMemmemCRLF = [](const char* p, size_t n) { return static_cast<const char*>(memmem(p, n, "\r\n", 2)); };
+constexpr auto kFindSequenceCRLF = [](const char* p, size_t n) {
+  return internal::FindSequence<char, '\r', '\n'>(p, n);
+};
+
+struct SearchContender {
+  const char* name;
+  auto (*run)(std::string_view text) -> Sample;
+};
+
+void RunSearch(const char* title, std::string_view newline, const std::vector<SearchContender>& contenders) {
+  constexpr size_t kSize = 64 << 20;
+  printf("\ndelimiter search, %s, %zu MiB in memory (%s)\n", title, kSize >> 20,
+         internal::simd::kEnabled ? "SIMD" : "scalar");
+  printf("  %-40s %10s %10s %9s\n", "contender", "line bytes", "records", "MiB/s");
+  for (auto length : {16, 80, 1024, 4096, 16384}) {
+    auto text = MakeLines(kSize, static_cast<size_t>(length), newline);
+    for (auto& contender : contenders) {
+      auto best = std::chrono::nanoseconds::max();
+      Sample sample{};
+      for (int i = 0; i < kRepeats; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        sample = contender.run(text);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed));
+      }
+      auto seconds = std::chrono::duration<double>(best).count();
+      printf("  %-40s %10d %10" PRIu64 " %9.1f\n", contender.name, length, sample.records,
+             static_cast<double>(text.size()) / seconds / (1 << 20));
+    }
+  }
+}
+
+void RunSearches() {
+  RunSearch("LF", "\n",
+            {{"memchr", SearchLines<kMemchrLF, 1>}, {"FindAnyOf<'\\n'>", SearchLines<kFindAnyOfLF, 1>}});
+  RunSearch("CRLF", "\r\n",
+            {{"memmem", SearchLines<kMemmemCRLF, 2>},
+             {"FindSequence<'\\r', '\\n'>", SearchLines<kFindSequenceCRLF, 2>}});
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  auto workdir = std::string{argc > 1 ? argv[1] : "/tmp/reader_benchmark"};
+  uint64_t size = (argc > 2 ? strtoull(argv[2], nullptr, 10) : 64) << 20;
+  size_t entries = argc > 3 ? strtoull(argv[3], nullptr, 10) : 100'000;
+
+  // Inputs are keyed by their parameters, so changing them never reuses a stale file.
+  auto suffix = std::to_string(size >> 20) + "M";
+  auto short_lines = workdir + "/short-" + suffix + ".txt";
+  auto long_lines = workdir + "/long-" + suffix + ".txt";
+  auto crlf_lines = workdir + "/crlf-" + suffix + ".txt";
+  auto utf16_lines = workdir + "/utf16-" + suffix + ".txt";
+  auto directory = workdir + "/dir-" + std::to_string(entries);
+  auto small_input = workdir + "/short-64K.txt";
+  // Lines of one fixed length each, from a quarter of the chunked readers' buffer to four times it.
+  std::vector<std::pair<std::string, size_t>> chunked_inputs;
+  for (size_t length : {4 * 1024, 16 * 1024, 64 * 1024}) {
+    chunked_inputs.emplace_back(workdir + "/crlf-" + std::to_string(length) + "-" + suffix + ".txt", length);
+  }
+  auto large_input = workdir + "/short-4M.txt";
+
+  std::error_code ec;
+  std::filesystem::create_directories(workdir, ec);
+  if (ec || !WriteLines<char>(short_lines, size, 8, 80, kAlphabet, "\n") ||
+      !WriteLines<char>(long_lines, size, 1024, 32 * 1024, kAlphabet, "\n") ||
+      !WriteLines<char>(crlf_lines, size, 8, 80, kAlphabet, "\r\n") ||
+      !WriteLines<char16_t>(utf16_lines, size, 8, 80, kAlphabet16, u"\n") || !MakeDirectory(directory, entries) ||
+      !WriteLines<char>(small_input, 64 * 1024 - 128, 8, 80, kAlphabet, "\n") ||
+      !WriteLines<char>(large_input, 4 * 1024 * 1024 - 128, 8, 80, kAlphabet, "\n")) {
+    fprintf(stderr, "cannot create the inputs in %s\n", workdir.c_str());
+    return 1;
+  }
+  for (auto& [path, length] : chunked_inputs) {
+    if (!WriteLines<char>(path, size, length, length, kAlphabet, "\r\n")) {
+      fprintf(stderr, "cannot create the inputs in %s\n", workdir.c_str());
+      return 1;
+    }
+  }
+
+  auto bench = Bench{};
+  printf("cycles: %s, syscalls: %s\n", bench.cycles.IsValid() ? "perf_event_open" : "unavailable",
+         bench.syscalls.IsValid() ? "raw_syscalls tracepoint" : "unavailable");
+
+  std::vector<Contender> lf;
+  AddFileReaders<UTF8::LF>(lf);
+  lf.push_back({.name = "std::getline", .run = GetlineLines<false>, .reads = nullptr});
+  lf.push_back({.name = "fgets", .run = FgetsLines<false>, .reads = nullptr});
+  bench.Run("short lines", short_lines.c_str(), lf);
+  bench.Run("long lines", long_lines.c_str(), lf);
+
+  std::vector<Contender> crlf;
+  AddFileReaders<UTF8::CRLF>(crlf);
+  crlf.push_back({.name = "std::getline", .run = GetlineLines<true>, .reads = nullptr});
+  crlf.push_back({.name = "fgets", .run = FgetsLines<true>, .reads = nullptr});
+  bench.Run("CRLF", crlf_lines.c_str(), crlf);
+
+  std::vector<Contender> utf16;
+  AddFileReaders<UTF16::LF>(utf16);
+  utf16.push_back({.name = "fread + u16string_view::find", .run = FreadLines16, .reads = nullptr});
+  bench.Run("UTF-16", utf16_lines.c_str(), utf16);
+
+  std::vector<Contender> dir;
+  AddDirReader<StackBuffer<4 * 1024>>(dir, "StackBuffer<4K>");
+  AddDirReader<StackBuffer<16 * 1024>>(dir, "StackBuffer<16K>");
+  AddDirReader<StackBuffer<64 * 1024>>(dir, "StackBuffer<64K>");
+  AddDirReader<HeapBuffer<64 * 1024>>(dir, "HeapBuffer<64K>");
+  AddDirReader<HeapBuffer<1024 * 1024>>(dir, "HeapBuffer<1M>");
+  AddDirReader<MMapBuffer<64 * 1024>>(dir, "MMapBuffer<64K>");
+  AddDirReader<MMapBuffer<1024 * 1024>>(dir, "MMapBuffer<1M>");
+  dir.push_back({.name = "readdir", .run = ReaddirEntries, .reads = nullptr});
+  dir.push_back({.name = "std::filesystem::directory_iterator", .run = DirectoryIteratorEntries, .reads = nullptr});
+  bench.Run("directory", directory.c_str(), dir);
+
+  RunChunkedSources(chunked_inputs);
+  RunSearches();
+  RunSetups(small_input.c_str(), large_input.c_str());
+  return 0;
+}
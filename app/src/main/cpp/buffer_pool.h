@@ -0,0 +1,181 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace io {
+struct BufferPoolStats {
+  // Buffers that had to be allocated from the heap.
+  uint64_t allocated;
+  // Buffers handed out again from the thread-local free list.
+  uint64_t reused_local;
+  // Buffers handed out again from the shared pool.
+  uint64_t reused_shared;
+  // Buffers given back to the heap because every free list was full.
+  uint64_t freed;
+
+  [[nodiscard]] auto allocations_avoided() const { return reused_local + reused_shared; }
+};
+
+namespace internal {
+// Counters are kept per policy, shared by every allocation size the policy is instantiated with.
+template <size_t kPolicySize, bool kShared>
+struct BufferPoolCounters {
+  static inline std::atomic<uint64_t> allocated{};
+  static inline std::atomic<uint64_t> reused_local{};
+  static inline std::atomic<uint64_t> reused_shared{};
+  static inline std::atomic<uint64_t> freed{};
+
+  [[nodiscard]] static auto Get() -> BufferPoolStats {
+    return {
+        .allocated = allocated.load(std::memory_order_relaxed),
+        .reused_local = reused_local.load(std::memory_order_relaxed),
+        .reused_shared = reused_shared.load(std::memory_order_relaxed),
+        .freed = freed.load(std::memory_order_relaxed),
+    };
+  }
+};
+
+/**
+ * Recycles fixed-size buffers of kSize bytes. Every thread keeps a small free list of its own;
+ * with kShared, buffers that do not fit there go to a process-wide pool made of atomic slots,
+ * which other threads drain before touching the heap. Each slot is claimed with a single
+ * exchange, so the shared pool is lock-free and immune to ABA.
+ */
+template <size_t kPolicySize, size_t kSize, bool kShared>
+class BufferPool {
+ public:
+  static auto Acquire() -> uint8_t* {
+    auto& local = LocalList();
+    if (local.count > 0) [[likely]] {
+      Counters::reused_local.fetch_add(1, std::memory_order_relaxed);
+      return local.buffers[--local.count];
+    }
+
+    if constexpr (kShared) {
+      for (auto& slot : shared_) {
+        if (slot.load(std::memory_order_relaxed) == nullptr) continue;
+        if (auto buffer = slot.exchange(nullptr, std::memory_order_acquire)) {
+          Counters::reused_shared.fetch_add(1, std::memory_order_relaxed);
+          return buffer;
+        }
+      }
+    }
+
+    Counters::allocated.fetch_add(1, std::memory_order_relaxed);
+    return new uint8_t[kSize];
+  }
+
+  static void Release(uint8_t* buffer) {
+    auto& local = LocalList();
+    if (local.count < kLocalCapacity) [[likely]] {
+      local.buffers[local.count++] = buffer;
+      return;
+    }
+    Discard(buffer);
+  }
+
+ private:
+  using Counters = BufferPoolCounters<kPolicySize, kShared>;
+
+  static constexpr size_t kLocalCapacity = 4;
+  static constexpr size_t kSharedCapacity = 16;
+
+  struct LocalFreeList {
+    std::array<uint8_t*, kLocalCapacity> buffers{};
+    size_t count{};
+
+    ~LocalFreeList() {
+      while (count > 0) Discard(buffers[--count]);
+    }
+  };
+
+  static auto LocalList() -> LocalFreeList& {
+    thread_local LocalFreeList list;
+    return list;
+  }
+
+  static void Discard(uint8_t* buffer) {
+    if constexpr (kShared) {
+      for (auto& slot : shared_) {
+        uint8_t* expected = nullptr;
+        if (slot.compare_exchange_strong(expected, buffer, std::memory_order_release, std::memory_order_relaxed)) {
+          return;
+        }
+      }
+    }
+    Counters::freed.fetch_add(1, std::memory_order_relaxed);
+    delete[] buffer;
+  }
+
+  static inline std::array<std::atomic<uint8_t*>, kShared ? kSharedCapacity : 0> shared_{};
+};
+}  // namespace internal
+
+/**
+ * A heap buffer policy that recycles its storage instead of allocating per reader.
+ *
+ * Buffers come from a thread-local free list and go back to it on destruction; with `kShared`
+ * they can also migrate between threads through a small lock-free pool. Unlike HeapBuffer the
+ * memory is not zeroed. Use `stats()` to see how many allocations were avoided.
+ *
+ * @code
+ * for (auto entry : DirReader<>{"/proc"}) {
+ *   if (!entry.is_directory()) continue;
+ *   for (auto line : FileReader<DefaultPooledBuffer>{proc_fd, entry.name().data()}) {}
+ * }
+ * auto avoided = DefaultPooledBuffer::stats().allocations_avoided();
+ * @endcode
+ */
+template <size_t kDefaultBufferSize, bool kShared = false, size_t kAllocSize = kDefaultBufferSize>
+struct PooledBuffer {
+  template <size_t kBufferSize = kDefaultBufferSize>
+  using type = PooledBuffer<kDefaultBufferSize, kShared, kBufferSize>;
+
+  static constexpr auto size = kDefaultBufferSize;
+
+  template <size_t kBufferSize = kDefaultBufferSize>
+    requires(kBufferSize > 0)
+  static constexpr auto make_buffer() -> type<kBufferSize> {
+    return {};
+  }
+
+  [[nodiscard]] static auto stats() -> BufferPoolStats {
+    return internal::BufferPoolCounters<kDefaultBufferSize, kShared>::Get();
+  }
+
+  auto operator[](size_t index) const { return base_[index]; }
+  auto operator[](size_t index) -> auto& { return base_[index]; }
+
+  PooledBuffer(PooledBuffer&& other) noexcept : base_{std::exchange(other.base_, nullptr)} {}
+
+  auto operator=(PooledBuffer&& other) noexcept -> auto& {
+    if (this != &other) {
+      if (base_) Pool::Release(base_);
+      base_ = std::exchange(other.base_, nullptr);
+    }
+    return *this;
+  }
+
+  PooledBuffer() : base_{Pool::Acquire()} {}
+
+  ~PooledBuffer() {
+    if (base_) [[likely]] {
+      Pool::Release(base_);
+    }
+  }
+
+  PooledBuffer(const PooledBuffer&) = delete;
+  void operator=(const PooledBuffer&) = delete;
+
+ private:
+  using Pool = internal::BufferPool<kDefaultBufferSize, kAllocSize, kShared>;
+
+  uint8_t* base_;
+};
+
+using DefaultPooledBuffer = PooledBuffer<32 * 1024>;
+}  // namespace io
@@ -0,0 +1,131 @@
+#include "checksum.h"
+
+#include <fcntl.h>
+
+#include <array>
+#include <bit>
+#include <cstring>
+
+#if defined(__aarch64__)
+#include <arm_acle.h>
+#include <sys/auxv.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <nmmintrin.h>
+#endif
+
+namespace io {
+namespace {
+// Reflected CRC-32C polynomial.
+constexpr uint32_t kPolynomial = 0x82f63b78;
+
+// Slicing-by-8: kTables[k][b] is the CRC of byte b followed by k zero bytes.
+constexpr auto kTables = [] consteval {
+  std::array<std::array<uint32_t, 256>, 8> tables{};
+  for (uint32_t b = 0; b < 256; ++b) {
+    auto crc = b;
+    for (int i = 0; i < 8; ++i) crc = (crc >> 1) ^ (kPolynomial & (0u - (crc & 1)));
+    tables[0][b] = crc;
+  }
+  for (size_t k = 1; k < tables.size(); ++k) {
+    for (size_t b = 0; b < 256; ++b) tables[k][b] = (tables[k - 1][b] >> 8) ^ tables[0][tables[k - 1][b] & 0xff];
+  }
+  return tables;
+}();
+
+auto Load64(const uint8_t* p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+auto Software(uint32_t crc, const uint8_t* p, size_t size) -> uint32_t {
+  for (; size >= 8; p += 8, size -= 8) {
+    auto v = Load64(p) ^ crc;
+    if constexpr (std::endian::native == std::endian::big) v = __builtin_bswap64(v);
+    crc = kTables[7][v & 0xff] ^ kTables[6][(v >> 8) & 0xff] ^ kTables[5][(v >> 16) & 0xff] ^
+          kTables[4][(v >> 24) & 0xff] ^ kTables[3][(v >> 32) & 0xff] ^ kTables[2][(v >> 40) & 0xff] ^
+          kTables[1][(v >> 48) & 0xff] ^ kTables[0][v >> 56];
+  }
+  for (; size > 0; ++p, --size) crc = (crc >> 8) ^ kTables[0][(crc ^ *p) & 0xff];
+  return crc;
+}
+
+#if defined(__aarch64__)
+// The NDK targets plain ARMv8.0, where the CRC32 instructions are optional.
+#if defined(__clang__)
+#define CRC_TARGET [[gnu::target("crc")]]
+#else
+#define CRC_TARGET [[gnu::target("+crc")]]
+#endif
+
+CRC_TARGET auto Hardware(uint32_t crc, const uint8_t* p, size_t size) -> uint32_t {
+  for (; size >= 8; p += 8, size -= 8) crc = __crc32cd(crc, Load64(p));
+  for (; size > 0; ++p, --size) crc = __crc32cb(crc, *p);
+  return crc;
+}
+
+auto HasHardware() -> bool {
+  // HWCAP_CRC32 of <asm/hwcap.h>.
+  return getauxval(AT_HWCAP) & (1 << 7);
+}
+#elif defined(__x86_64__) || defined(__i386__)
+[[gnu::target("sse4.2")]] auto Hardware(uint32_t crc, const uint8_t* p, size_t size) -> uint32_t {
+#if defined(__x86_64__)
+  uint64_t crc64 = crc;
+  for (; size >= 8; p += 8, size -= 8) crc64 = _mm_crc32_u64(crc64, Load64(p));
+  crc = static_cast<uint32_t>(crc64);
+#endif
+  for (; size >= 4; p += 4, size -= 4) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    crc = _mm_crc32_u32(crc, v);
+  }
+  for (; size > 0; ++p, --size) crc = _mm_crc32_u8(crc, *p);
+  return crc;
+}
+
+auto HasHardware() -> bool {
+  unsigned eax, ebx, ecx, edx;
+  return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSE4_2);
+}
+#else
+auto Hardware(uint32_t crc, const uint8_t* p, size_t size) -> uint32_t { return Software(crc, p, size); }
+
+auto HasHardware() -> bool { return false; }
+#endif
+}  // namespace
+
+auto Crc32c(uint32_t crc, const void* data, size_t size) -> uint32_t {
+  static const auto kHardware = HasHardware();
+  auto p = static_cast<const uint8_t*>(data);
+  crc = ~crc;
+  crc = kHardware ? Hardware(crc, p, size) : Software(crc, p, size);
+  return ~crc;
+}
+
+auto Checksum(int dirfd, const char* pathname) -> std::optional<std::pair<uint32_t, uint64_t>> {
+  auto fd = raw_openat(dirfd, pathname, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) [[unlikely]] {
+    return {};
+  }
+
+  std::array<uint8_t, 16 * 1024> buffer;
+  uint32_t crc = 0;
+  uint64_t size = 0;
+  ssize_t n;
+  while ((n = raw_read(fd, buffer.data(), buffer.size())) != 0) {
+    if (n == -EINTR) continue;
+    if (n < 0) [[unlikely]] {
+      break;
+    }
+    crc = Crc32c(crc, buffer.data(), static_cast<size_t>(n));
+    size += static_cast<uint64_t>(n);
+  }
+  raw_close(fd);
+  if (n < 0) [[unlikely]] {
+    return {};
+  }
+  return std::pair{crc, size};
+}
+}  // namespace io
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include "file_reader.h"
+
+namespace io {
+/**
+ * @brief CRC-32C (Castagnoli) of `size` bytes, continuing from the checksum of the bytes before them.
+ *
+ * Uses the CRC32 instructions of ARMv8 and SSE4.2 when the CPU has them, checked once at runtime,
+ * and a table driven loop otherwise (armeabi-v7a, riscv64, old x86).
+ *
+ * @code
+ * auto crc = Crc32c(0, header, sizeof(header));
+ * crc = Crc32c(crc, body, body_size);  // Same as one call over header and body.
+ * @endcode
+ */
+auto Crc32c(uint32_t crc, const void* data, size_t size) -> uint32_t;
+
+/**
+ * @brief CRC-32C and length of a whole file, read in one pass through a stack buffer.
+ *
+ * Suits the checks that only need to know whether a file changed, such as comparing an on-disk
+ * library to a known build, without splitting it into lines.
+ *
+ * @return Nothing if the file could not be opened or read.
+ */
+auto Checksum(int dirfd, const char* pathname) -> std::optional<std::pair<uint32_t, uint64_t>>;
+
+inline auto Checksum(const char* pathname) { return Checksum(AT_FDCWD, pathname); }
+
+/**
+ * Stats policy that computes the CRC-32C of the bytes a reader delivers while they stream through
+ * it, so a file is fingerprinted in the same pass that parses it. Once the reader reaches the end,
+ * the checksum covers the whole file; lines skipped by SeekToLine are not included.
+ *
+ * @code
+ * auto reader = FileReader<DefaultStackBuffer, UTF8::LF, ChecksumStats>{"/proc/self/maps"};
+ * for (auto line : reader) {}
+ * if (reader.GetStats().crc32c == last_crc32c) {}  // Nothing changed since the last scan.
+ * @endcode
+ */
+struct ChecksumStats {
+  static constexpr bool kEnabled = true;
+  static constexpr bool kTimed = false;
+
+  uint32_t crc32c;
+  // Bytes the checksum covers.
+  uint64_t size;
+
+  void OnRead(ssize_t, uint64_t) {}
+  void OnReduce(size_t) {}
+  void OnBufferFull(size_t) {}
+
+  void OnDeliver(const uint8_t* data, size_t n) {
+    crc32c = Crc32c(crc32c, data, n);
+    size += n;
+  }
+};
+}  // namespace io
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+
+namespace io::internal {
+namespace swar {
+// Digits are handled eight at a time in a 64-bit word, the first one in the lowest byte, so a
+// 16-byte step costs two loads, a handful of ALU operations and three multiplications per word.
+static constexpr uint64_t kOnes = 0x0101010101010101;
+
+static constexpr auto kPowersOf10 = [] consteval {
+  std::array<uint64_t, 9> powers{1};
+  for (size_t i = 1; i < powers.size(); ++i) powers[i] = powers[i - 1] * 10;
+  return powers;
+}();
+
+// Number of ASCII digits at the start of `word`, 0 to 8.
+[[gnu::always_inline]] inline auto CountDigits(uint64_t word) -> unsigned {
+  // A digit has the high nibble 3 both before and after adding 6; the carry out of a byte of 0xfa
+  // or more only reaches bytes after a non-digit.
+  auto nibbles = (word & (kOnes * 0xf0)) | (((word + kOnes * 0x06) & (kOnes * 0xf0)) >> 4);
+  auto non_digits = nibbles ^ (kOnes * 0x33);
+  return non_digits == 0 ? 8 : static_cast<unsigned>(std::countr_zero(non_digits)) / 8;
+}
+
+// Value of the first `count` (1 to 8) bytes of `word`, which are digits.
+[[gnu::always_inline]] inline auto ConvertDigits(uint64_t word, unsigned count) -> uint64_t {
+  // Leading zeros shifted in on the low side make every number eight digits long; the bytes after
+  // the digits, including any borrow from them, are shifted out.
+  word = (word - kOnes * '0') << (8 * (8 - count));
+  // Pairs of digits, then pairs of pairs, combined by multiplication.
+  word = word * 10 + (word >> 8);
+  return (((word & 0x000000ff000000ff) * (100 + (1000000ull << 32))) +
+          (((word >> 16) & 0x000000ff000000ff) * (1 + (10000ull << 32)))) >>
+         32;
+}
+}  // namespace swar
+
+/**
+ * Value of the decimal digits at the start of [data, data + size), up to 16 digits per step, and the
+ * number of digits. Unlike strtoull it skips no blanks, ignores the locale and wraps around instead
+ * of saturating past UINT64_MAX, which the kernel never prints.
+ */
+inline auto ParseDecimal(const char* data, size_t size) -> std::pair<uint64_t, size_t> {
+  uint64_t value = 0;
+  size_t count = 0;
+  // Adds the digits at the start of a word; false once the number has ended.
+  auto step = [&](uint64_t word) {
+    auto digits = swar::CountDigits(word);
+    if (digits == 0) return false;
+    value = value * swar::kPowersOf10[digits] + swar::ConvertDigits(word, digits);
+    count += digits;
+    return digits == 8;
+  };
+
+  if constexpr (std::endian::native == std::endian::little) {
+    while (size - count >= 16) {
+      std::array<uint64_t, 2> words;
+      memcpy(words.data(), data + count, sizeof(words));
+      if (!step(words[0]) || !step(words[1])) return {value, count};
+    }
+    if (size - count >= 8) {
+      uint64_t word;
+      memcpy(&word, data + count, sizeof(word));
+      if (!step(word)) return {value, count};
+    }
+  }
+  // Fewer than eight bytes left, where a loop beats assembling a padded word.
+  for (; count < size && static_cast<unsigned char>(data[count] - '0') < 10; ++count) {
+    value = value * 10 + static_cast<unsigned char>(data[count] - '0');
+  }
+  return {value, count};
+}
+
+// Leading number of a procfs value such as the "123" of "123 kB": digits up to the end, a blank or a
+// tab, as strtoul followed by a check of the end pointer would accept.
+inline auto ParseNumber(std::string_view text) -> std::optional<uint64_t> {
+  auto [value, digits] = ParseDecimal(text.data(), text.size());
+  if (digits == 0 || (digits < text.size() && text[digits] != ' ' && text[digits] != '\t')) [[unlikely]] {
+    return {};
+  }
+  return value;
+}
+
+// ParseNumber over all the values of a record at once; the conversions are independent, so they
+// overlap in the pipeline. `out` must be at least as long as `texts`.
+inline void ParseNumbers(std::span<const std::string_view> texts, std::span<std::optional<uint64_t>> out) {
+  for (size_t i = 0; i < texts.size(); ++i) out[i] = ParseNumber(texts[i]);
+}
+}  // namespace io::internal
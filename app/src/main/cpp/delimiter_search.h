@@ -0,0 +1,260 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace io::internal {
+namespace simd {
+// Thin per-ISA vector layer. Every comparison yields a bitmask in which each input byte owns
+// kMaskStride consecutive bits, so the byte offset of a hit is always countr_zero(mask) / kMaskStride.
+#if defined(__AVX2__)
+static constexpr bool kEnabled = true;
+static constexpr size_t kWidth = 32;
+static constexpr unsigned kMaskStride = 1;
+using Vector = __m256i;
+
+[[gnu::always_inline]] inline auto Load(const void* p) { return _mm256_loadu_si256(static_cast<const __m256i*>(p)); }
+
+template <typename T>
+[[gnu::always_inline]] inline auto Splat(T c) {
+  if constexpr (sizeof(T) == 1) return _mm256_set1_epi8(static_cast<char>(c));
+  else if constexpr (sizeof(T) == 2) return _mm256_set1_epi16(static_cast<short>(c));
+  else return _mm256_set1_epi32(static_cast<int>(c));
+}
+
+template <typename T>
+[[gnu::always_inline]] inline auto Equal(Vector a, Vector b) {
+  if constexpr (sizeof(T) == 1) return _mm256_cmpeq_epi8(a, b);
+  else if constexpr (sizeof(T) == 2) return _mm256_cmpeq_epi16(a, b);
+  else return _mm256_cmpeq_epi32(a, b);
+}
+
+[[gnu::always_inline]] inline auto And(Vector a, Vector b) { return _mm256_and_si256(a, b); }
+[[gnu::always_inline]] inline auto Or(Vector a, Vector b) { return _mm256_or_si256(a, b); }
+
+[[gnu::always_inline]] inline auto ToMask(Vector v) {
+  return static_cast<uint64_t>(static_cast<uint32_t>(_mm256_movemask_epi8(v)));
+}
+#elif defined(__SSE2__)
+static constexpr bool kEnabled = true;
+static constexpr size_t kWidth = 16;
+static constexpr unsigned kMaskStride = 1;
+using Vector = __m128i;
+
+[[gnu::always_inline]] inline auto Load(const void* p) { return _mm_loadu_si128(static_cast<const __m128i*>(p)); }
+
+template <typename T>
+[[gnu::always_inline]] inline auto Splat(T c) {
+  if constexpr (sizeof(T) == 1) return _mm_set1_epi8(static_cast<char>(c));
+  else if constexpr (sizeof(T) == 2) return _mm_set1_epi16(static_cast<short>(c));
+  else return _mm_set1_epi32(static_cast<int>(c));
+}
+
+template <typename T>
+[[gnu::always_inline]] inline auto Equal(Vector a, Vector b) {
+  if constexpr (sizeof(T) == 1) return _mm_cmpeq_epi8(a, b);
+  else if constexpr (sizeof(T) == 2) return _mm_cmpeq_epi16(a, b);
+  else return _mm_cmpeq_epi32(a, b);
+}
+
+[[gnu::always_inline]] inline auto And(Vector a, Vector b) { return _mm_and_si128(a, b); }
+[[gnu::always_inline]] inline auto Or(Vector a, Vector b) { return _mm_or_si128(a, b); }
+
+[[gnu::always_inline]] inline auto ToMask(Vector v) { return static_cast<uint64_t>(_mm_movemask_epi8(v)); }
+#elif defined(__ARM_NEON)
+static constexpr bool kEnabled = true;
+static constexpr size_t kWidth = 16;
+static constexpr unsigned kMaskStride = 4;
+using Vector = uint8x16_t;
+
+[[gnu::always_inline]] inline auto Load(const void* p) { return vld1q_u8(static_cast<const uint8_t*>(p)); }
+
+template <typename T>
+[[gnu::always_inline]] inline auto Splat(T c) {
+  if constexpr (sizeof(T) == 1) return vdupq_n_u8(static_cast<uint8_t>(c));
+  else if constexpr (sizeof(T) == 2) return vreinterpretq_u8_u16(vdupq_n_u16(static_cast<uint16_t>(c)));
+  else return vreinterpretq_u8_u32(vdupq_n_u32(static_cast<uint32_t>(c)));
+}
+
+template <typename T>
+[[gnu::always_inline]] inline auto Equal(Vector a, Vector b) {
+  if constexpr (sizeof(T) == 1) return vceqq_u8(a, b);
+  else if constexpr (sizeof(T) == 2) return vreinterpretq_u8_u16(vceqq_u16(vreinterpretq_u16_u8(a), vreinterpretq_u16_u8(b)));
+  else return vreinterpretq_u8_u32(vceqq_u32(vreinterpretq_u32_u8(a), vreinterpretq_u32_u8(b)));
+}
+
+[[gnu::always_inline]] inline auto And(Vector a, Vector b) { return vandq_u8(a, b); }
+[[gnu::always_inline]] inline auto Or(Vector a, Vector b) { return vorrq_u8(a, b); }
+
+// Narrowing shift packs every byte of the comparison result into one nibble of a 64-bit scalar.
+[[gnu::always_inline]] inline auto ToMask(Vector v) {
+  return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(v), 4)), 0);
+}
+#else
+// Scalar fallback: callers branch on kEnabled, the declarations below only keep the discarded code well-formed.
+static constexpr bool kEnabled = false;
+static constexpr size_t kWidth = 0;
+static constexpr unsigned kMaskStride = 1;
+struct Vector {};
+
+auto Load(const void* p) -> Vector;
+template <typename T>
+auto Splat(T c) -> Vector;
+template <typename T>
+auto Equal(Vector a, Vector b) -> Vector;
+auto And(Vector a, Vector b) -> Vector;
+auto Or(Vector a, Vector b) -> Vector;
+auto ToMask(Vector v) -> uint64_t;
+#endif
+
+// Mask bits covering one element of type T.
+template <typename T>
+static constexpr uint64_t kElementBits = (uint64_t{1} << (sizeof(T) * kMaskStride)) - 1;
+
+template <typename T>
+[[gnu::always_inline]] inline auto ElementIndex(uint64_t mask) -> size_t {
+  return static_cast<size_t>(std::countr_zero(mask)) / kMaskStride / sizeof(T);
+}
+
+// Index of the last element with a bit set in `mask`.
+template <typename T>
+[[gnu::always_inline]] inline auto LastElementIndex(uint64_t mask) -> size_t {
+  return static_cast<size_t>(63 - std::countl_zero(mask)) / kMaskStride / sizeof(T);
+}
+
+template <typename T, T kHead, T... kTail>
+[[gnu::always_inline]] inline auto EqualAny(Vector v) {
+  auto hits = Equal<T>(v, Splat(kHead));
+  ((hits = Or(hits, Equal<T>(v, Splat(kTail)))), ...);
+  return hits;
+}
+}  // namespace simd
+
+/**
+ * Returns the first element of [p, p + n) that equals any of `kSet`, or nullptr.
+ * The set is fixed at compile time and checked with one compare per member per vector.
+ */
+template <typename CharT, CharT... kSet>
+  requires(sizeof...(kSet) > 0)
+[[gnu::always_inline]] inline auto FindAnyOf(const CharT* p, size_t n) -> const CharT* {
+  size_t i = 0;
+
+  if constexpr (simd::kEnabled) {
+    constexpr size_t kStep = simd::kWidth / sizeof(CharT);
+    for (; i + kStep <= n; i += kStep) {
+      auto hits = simd::EqualAny<CharT, kSet...>(simd::Load(p + i));
+      if (auto mask = simd::ToMask(hits)) [[unlikely]] {
+        return p + i + simd::ElementIndex<CharT>(mask);
+      }
+    }
+  }
+
+  for (; i < n; ++i) {
+    if (((p[i] == kSet) || ...)) return p + i;
+  }
+  return nullptr;
+}
+
+/**
+ * Returns the start of the first occurrence of `kSeq` in [p, p + n), or nullptr.
+ *
+ * Candidates are found by comparing the first and the last element of the sequence at their
+ * respective offsets in one pass; two-element sequences such as CRLF need no further check,
+ * longer ones verify the middle with memcmp.
+ */
+template <typename CharT, CharT... kSeq>
+  requires(sizeof...(kSeq) > 1)
+[[gnu::always_inline]] inline auto FindSequence(const CharT* p, size_t n) -> const CharT* {
+  static constexpr CharT kNeedle[] = {kSeq...};
+  static constexpr size_t kLength = sizeof...(kSeq);
+
+  if (n < kLength) [[unlikely]] {
+    return nullptr;
+  }
+
+  size_t i = 0;
+
+  if constexpr (simd::kEnabled) {
+    constexpr size_t kStep = simd::kWidth / sizeof(CharT);
+    auto first = simd::Splat(kNeedle[0]);
+    auto last = simd::Splat(kNeedle[kLength - 1]);
+    for (; i + kLength - 1 + kStep <= n; i += kStep) {
+      auto hits = simd::And(simd::Equal<CharT>(simd::Load(p + i), first),
+                            simd::Equal<CharT>(simd::Load(p + i + kLength - 1), last));
+      for (auto mask = simd::ToMask(hits); mask;) {
+        auto candidate = p + i + simd::ElementIndex<CharT>(mask);
+        if constexpr (kLength == 2) {
+          return candidate;
+        } else if (memcmp(candidate + 1, kNeedle + 1, (kLength - 2) * sizeof(CharT)) == 0) {
+          return candidate;
+        }
+        mask &= ~(simd::kElementBits<CharT> << std::countr_zero(mask));
+      }
+    }
+  }
+
+  if constexpr (sizeof(CharT) == 1) {
+    return static_cast<const CharT*>(memmem(p + i, n - i, kNeedle, kLength));
+  } else {
+    for (; i + kLength <= n; ++i) {
+      if (p[i] == kNeedle[0] && memcmp(p + i + 1, kNeedle + 1, (kLength - 1) * sizeof(CharT)) == 0) return p + i;
+    }
+    return nullptr;
+  }
+}
+
+/**
+ * Returns the last element of [p, p + n) that equals any of `kSet`, or nullptr: FindAnyOf scanning
+ * from the end, one vector at a time.
+ */
+template <typename CharT, CharT... kSet>
+  requires(sizeof...(kSet) > 0)
+[[gnu::always_inline]] inline auto FindLastAnyOf(const CharT* p, size_t n) -> const CharT* {
+  size_t i = n;
+
+  if constexpr (simd::kEnabled) {
+    constexpr size_t kStep = simd::kWidth / sizeof(CharT);
+    for (; i >= kStep; i -= kStep) {
+      auto hits = simd::EqualAny<CharT, kSet...>(simd::Load(p + i - kStep));
+      if (auto mask = simd::ToMask(hits)) [[unlikely]] {
+        return p + i - kStep + simd::LastElementIndex<CharT>(mask);
+      }
+    }
+  }
+
+  while (i > 0) {
+    --i;
+    if (((p[i] == kSet) || ...)) return p + i;
+  }
+  return nullptr;
+}
+
+/**
+ * Returns the start of the last occurrence of `kSeq` in [p, p + n), or nullptr. Candidates are the
+ * occurrences of its last element, found with FindLastAnyOf; the elements before it are verified
+ * with memcmp.
+ */
+template <typename CharT, CharT... kSeq>
+  requires(sizeof...(kSeq) > 1)
+[[gnu::always_inline]] inline auto FindLastSequence(const CharT* p, size_t n) -> const CharT* {
+  static constexpr CharT kNeedle[] = {kSeq...};
+  static constexpr size_t kLength = sizeof...(kSeq);
+
+  while (n >= kLength) {
+    auto last = FindLastAnyOf<CharT, kNeedle[kLength - 1]>(p + kLength - 1, n - (kLength - 1));
+    if (!last) return nullptr;
+    auto candidate = last - (kLength - 1);
+    if (memcmp(candidate, kNeedle, (kLength - 1) * sizeof(CharT)) == 0) return candidate;
+    n = static_cast<size_t>(last - p);
+  }
+  return nullptr;
+}
+}  // namespace io::internal
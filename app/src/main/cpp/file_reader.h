@@ -5,16 +5,22 @@
 
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cerrno>
+#include <chrono>
 #include <concepts>
 #include <cstring>
 #include <iterator>
 #include <memory>
 #include <optional>
+#include <span>
 #include <string_view>
+#include <tuple>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "delimiter_search.h"
 #include "linux_syscall_support.h"
 
 namespace io {
@@ -42,6 +48,36 @@ concept BufferPolicy = requires {
   { T::template make_buffer<T::size>() } -> std::same_as<typename T::template type<T::size>>;
 } && T::size > 0 && IndexableAddressable<typename T::template type<T::size>>;
 
+// Buffers whose storage is mapped twice back to back, so [i, i + size) is contiguous for any i < size.
+template <typename T>
+concept WrappingBuffer = requires {
+  requires T::kWrapsAround;
+};
+
+// Buffers that can enlarge themselves at runtime instead of splitting a record that does not fit.
+template <typename T>
+concept GrowableBuffer = requires {
+  requires T::kGrowable;
+};
+
+// Buffers meant for O_DIRECT: the data is read in blocks of kDirectIOAlignment bytes, at addresses
+// and file offsets aligned to it.
+template <typename T>
+concept DirectBuffer = requires {
+  requires T::kDirectIOAlignment > 0;
+};
+
+// Buffers held inside the reader object itself rather than behind a handle.
+template <typename T>
+concept InlineBuffer = requires {
+  requires T::kInline;
+};
+
+// Buffers that a reader can swap for a fresh one while views into the old one stay valid: the
+// storage lives behind a handle, so moving the handle aside keeps the bytes where they are.
+template <typename T>
+concept PinnableBuffer = !InlineBuffer<T> && !WrappingBuffer<T> && !DirectBuffer<T>;
+
 template <typename A, std::integral T>
 static constexpr auto AlignDown(T p) -> T {
   if constexpr (sizeof(A) == 1) {
@@ -87,7 +123,11 @@ struct FixedString {
 
   [[nodiscard]] consteval auto empty() const -> bool { return size() == 0; }
 
+  // Whether the string is a set of single-unit delimiters rather than one delimiter sequence.
+  [[nodiscard]] consteval auto is_any_of() const -> bool { return any_of_; }
+
   value_type data_[N != 0 ? N - 1 : N]{};
+  bool any_of_{};
 };
 
 template <class Reader>
@@ -129,8 +169,90 @@ class Iterator {
   Reader* reader_{};
   value_type current_{};
 };
+}  // namespace internal
+
+struct ReaderStats {
+  // Calls into the source (read, getdents64, ...), including interrupted ones and the one reporting the end.
+  uint64_t syscalls;
+  // Calls interrupted by a signal and retried.
+  uint64_t eintr_retries;
+  // Calls that added data to the buffer.
+  uint64_t refills;
+  // Bytes the source put into the buffer.
+  uint64_t bytes_read;
+  // Bytes handed out as records, delimiters included.
+  uint64_t bytes_delivered;
+  // Reduce() calls that moved a partial record to the front of the buffer, and the bytes moved.
+  uint64_t memmoves;
+  uint64_t memmove_bytes;
+  // Records returned in pieces because they did not fit into the buffer.
+  uint64_t buffer_full;
+  // Time spent inside the source calls, in nanoseconds.
+  uint64_t kernel_ns;
+};
+
+/**
+ * Stats policy of BaseReader readers that records nothing: every hook is an empty inline function
+ * and the member takes no space, so the reader compiles exactly as without instrumentation.
+ */
+struct NoStats {
+  static constexpr bool kEnabled = false;
+  static constexpr bool kTimed = false;
+
+  void OnRead(ssize_t, uint64_t) {}
+  void OnReduce(size_t) {}
+  void OnBufferFull(size_t) {}
+  void OnDeliver(const uint8_t*, size_t) {}
+};
+
+/**
+ * Stats policy that counts what a reader does, to size buffers for a workload.
+ *
+ * @code
+ * auto reader = FileReader<DefaultStackBuffer, UTF8::LF, CountingStats>{"/proc/self/smaps"};
+ * for (auto line : reader) {}
+ * auto& stats = reader.GetStats();
+ * LOGD("%lu reads, %lu memmoves, %lu truncated", stats.syscalls, stats.memmoves, stats.buffer_full);
+ * @endcode
+ */
+struct CountingStats : ReaderStats {
+  static constexpr bool kEnabled = true;
+  static constexpr bool kTimed = true;
+
+  void OnRead(ssize_t n, uint64_t ns) {
+    ++syscalls;
+    kernel_ns += ns;
+    if (n > 0) {
+      ++refills;
+      bytes_read += static_cast<uint64_t>(n);
+    } else if (n == -EINTR) {
+      ++eintr_retries;
+    }
+  }
+
+  void OnReduce(size_t moved) {
+    ++memmoves;
+    memmove_bytes += moved;
+  }
+
+  void OnBufferFull(size_t) { ++buffer_full; }
+
+  void OnDeliver(const uint8_t*, size_t size) { bytes_delivered += size; }
+};
+
+namespace internal {
+template <typename T>
+concept StatsPolicy = requires(T t, ssize_t n, uint64_t ns, size_t size, const uint8_t* data) {
+  { T::kEnabled } -> std::convertible_to<bool>;
+  // Whether OnRead wants the time spent in the source; reading the clock is skipped otherwise.
+  { T::kTimed } -> std::convertible_to<bool>;
+  t.OnRead(n, ns);
+  t.OnReduce(size);
+  t.OnBufferFull(size);
+  t.OnDeliver(data, size);
+};
 
-template <class Derived, class T, class Buffer>
+template <class Derived, class T, class Buffer, StatsPolicy Stats = NoStats>
 class BaseReader {
  public:
   using value_type = T;
@@ -142,18 +264,26 @@ class BaseReader {
   BaseReader(BaseReader&& other) noexcept
       : fd_{std::exchange(other.fd_, -1)},
         owned_{std::exchange(other.owned_, false)},
+        pinned_{std::exchange(other.pinned_, false)},
         buf_pos_{other.buf_pos_},
         buf_end_{other.buf_end_},
-        buffer_{std::move(other.buffer_)} {}
+        scanned_{other.scanned_},
+        stats_{other.stats_},
+        buffer_{std::move(other.buffer_)},
+        retired_{std::move(other.retired_)} {}
 
   auto operator=(BaseReader&& other) noexcept -> auto& {
     if (this != &other) {
       if (fd_ >= 0 && owned_) raw_close(fd_);
       fd_ = std::exchange(other.fd_, -1);
       owned_ = std::exchange(other.owned_, false);
+      pinned_ = std::exchange(other.pinned_, false);
       buf_pos_ = other.buf_pos_;
       buf_end_ = other.buf_end_;
+      scanned_ = other.scanned_;
+      stats_ = other.stats_;
       buffer_ = std::move(other.buffer_);
+      retired_ = std::move(other.retired_);
     }
     return *this;
   }
@@ -174,11 +304,81 @@ class BaseReader {
   [[nodiscard]] auto IsValid() const noexcept { return fd_ >= 0; }
   [[nodiscard]] auto GetFd() const noexcept { return fd_; }
 
+  [[nodiscard]] auto GetStats() const noexcept -> const Stats&
+    requires(Stats::kEnabled)
+  {
+    return stats_;
+  }
+
+  // Bytes the buffer can hold, which only changes for growable buffers.
+  [[nodiscard]] auto GetCapacity() const noexcept -> size_t {
+    if constexpr (GrowableBuffer<Buffer>) {
+      return buffer_.capacity();
+    } else if constexpr (DirectBuffer<Buffer>) {
+      // Including the block of slack that a partial record may leave unused in front of it.
+      return kBufferSize + Buffer::kDirectIOAlignment;
+    } else {
+      return kBufferSize;
+    }
+  }
+
+  /**
+   * Opens a window in which every record returned stays valid, until Unpin(). While pinned the
+   * reader never moves buffered data: when the buffer runs out, reading continues in a fresh one
+   * and the full one is kept aside, so a multi-line record can be parsed in place across refills.
+   *
+   * @code
+   * reader.Reduce();  // Start the record with the whole buffer free.
+   * reader.Pin();
+   * auto header = reader.NextLine();
+   * while (auto field = reader.NextLine()) {}  // `header` is still valid here.
+   * reader.Unpin();
+   * @endcode
+   */
+  void Pin() noexcept
+    requires(PinnableBuffer<Buffer>)
+  {
+    pinned_ = true;
+  }
+
+  // Closes the window of Pin(); the buffers kept aside for it are released.
+  void Unpin() noexcept
+    requires(PinnableBuffer<Buffer>)
+  {
+    pinned_ = false;
+    retired_.clear();
+  }
+
+  [[nodiscard]] auto IsPinned() const noexcept { return pinned_; }
+
+  // Moves the partial record to the front of the buffer. Does nothing while pinned.
   void Reduce() {
-    auto rem = buf_end_ - buf_pos_;
-    memmove(&buffer_[0], &buffer_[buf_pos_], rem);
-    buf_end_ = rem;
-    buf_pos_ = 0;
+    if (pinned_) [[unlikely]] {
+      return;
+    }
+    if constexpr (WrappingBuffer<Buffer>) {
+      // The mirror mapping already holds the data at pos - size; only the indices move.
+      if (buf_pos_ >= kBufferSize) {
+        buf_pos_ -= kBufferSize;
+        buf_end_ -= kBufferSize;
+      }
+    } else if constexpr (DirectBuffer<Buffer>) {
+      // The partial record is moved to end on a block boundary, so the next read stays aligned.
+      auto rem = buf_end_ - buf_pos_;
+      auto start = AlignUpTo(rem, Buffer::kDirectIOAlignment) - rem;
+      if (start != buf_pos_) {
+        stats_.OnReduce(rem);
+        memmove(&buffer_[start], &buffer_[buf_pos_], rem);
+        buf_pos_ = start;
+        buf_end_ = start + rem;
+      }
+    } else {
+      auto rem = buf_end_ - buf_pos_;
+      stats_.OnReduce(rem);
+      memmove(&buffer_[0], &buffer_[buf_pos_], rem);
+      buf_end_ = rem;
+      buf_pos_ = 0;
+    }
   }
 
   [[nodiscard]] auto begin() { return iterator{static_cast<Derived*>(this)}; }
@@ -193,57 +393,193 @@ class BaseReader {
     for (;;) {
       auto available = buf_end_ - buf_pos_;
 
-      if (auto res = parse_func(&buffer_[buf_pos_], available)) [[likely]] {
+      if (auto res = Parse(parse_func, available)) [[likely]] {
         auto [val, consumed] = *res;
+        stats_.OnDeliver(&buffer_[buf_pos_], consumed);
         buf_pos_ += consumed;
-        if (buf_pos_ == buf_end_) buf_pos_ = buf_end_ = 0;
+        if (buf_pos_ == buf_end_ && !pinned_) buf_pos_ = buf_end_ = 0;
         return val;
       }
 
-      if (buf_pos_ > 0 && buf_pos_ < buf_end_) [[likely]] {
+      if (pinned_) [[unlikely]] {
+        // Records returned since Pin() point into the buffer, so nothing in it may move.
+      } else if (buf_pos_ > 0 && buf_pos_ < buf_end_) [[likely]] {
         Reduce();
       } else if (buf_pos_ == buf_end_) {
         buf_pos_ = buf_end_ = 0;
       }
 
-      auto space = kBufferSize - buf_end_;
+      // A direct buffer may keep a gap before buf_pos_ (see Reduce) that cannot be read into.
+      auto space = DirectBuffer<Buffer> || pinned_ ? GetCapacity() - buf_end_ : GetCapacity() - (buf_end_ - buf_pos_);
+      if constexpr (PinnableBuffer<Buffer>) {
+        if (space == 0 && pinned_ && buf_pos_ > 0) [[unlikely]] {
+          SwapBuffer();
+          continue;
+        }
+      }
+      if constexpr (GrowableBuffer<Buffer>) {
+        if (space == 0 && buffer_.Grow(buf_end_)) [[unlikely]] {
+          continue;
+        }
+      }
       if (space == 0) [[unlikely]] {
-        return Derived::OnBufferFull(&buffer_[0], std::exchange(buf_end_, 0));
+        scanned_ = 0;
+        auto pos = std::exchange(buf_pos_, 0);
+        auto size = std::exchange(buf_end_, 0) - pos;
+        stats_.OnBufferFull(size);
+        stats_.OnDeliver(&buffer_[pos], size);
+        auto piece = Derived::OnBufferFull(&buffer_[pos], size);
+        if constexpr (PinnableBuffer<Buffer>) {
+          // The piece has to outlive the reads that follow it.
+          if (pinned_) SwapBuffer();
+        }
+        return piece;
       }
 
       ssize_t n;
       do {
-        n = Derived::ReadFromFD(fd_, &buffer_[buf_end_], space);
+        n = Read(space);
       } while (n == -EINTR);
 
       if (n <= 0) [[unlikely]] {
         eof_ = true;
-        return Derived::OnEOF(&buffer_[0], buf_end_);
+        stats_.OnDeliver(&buffer_[buf_pos_], buf_end_ - buf_pos_);
+        return Derived::OnEOF(&buffer_[buf_pos_], buf_end_ - buf_pos_);
       }
 
       buf_end_ += static_cast<size_t>(n);
     }
   }
 
+  // Fills `out` with the next record plus every further complete record already buffered, without
+  // reading again after the first one. All returned values stay valid until the next call that reads.
+  auto NextBatchImpl(std::span<value_type> out, auto&& parse_func) -> size_t {
+    if (out.empty()) [[unlikely]] {
+      return 0;
+    }
+
+    auto first = NextImpl(parse_func);
+    if (!first) [[unlikely]] {
+      return 0;
+    }
+    out[0] = std::move(*first);
+
+    size_t count = 1;
+    while (count < out.size() && !eof_ && buf_pos_ < buf_end_) {
+      auto res = Parse(parse_func, buf_end_ - buf_pos_);
+      if (!res) break;
+      auto [val, consumed] = *res;
+      out[count++] = val;
+      stats_.OnDeliver(&buffer_[buf_pos_], consumed);
+      buf_pos_ += consumed;
+    }
+    if (buf_pos_ == buf_end_ && !pinned_) buf_pos_ = buf_end_ = 0;
+    return count;
+  }
+
+  // Drops everything buffered, for sources that have just been repositioned.
+  void ResetBuffer() {
+    eof_ = false;
+    buf_pos_ = buf_end_ = scanned_ = 0;
+  }
+
+  // Reads until `count` bytes are buffered and drops them, for sources that can only be
+  // repositioned to aligned offsets. Must follow ResetBuffer.
+  auto Discard(size_t count) -> bool {
+    while (buf_end_ < count) {
+      ssize_t n;
+      do {
+        n = Read(GetCapacity() - buf_end_);
+      } while (n == -EINTR);
+      if (n <= 0) [[unlikely]] {
+        eof_ = true;
+        return false;
+      }
+      buf_end_ += static_cast<size_t>(n);
+    }
+    buf_pos_ = count;
+    if (buf_pos_ == buf_end_) buf_pos_ = buf_end_ = 0;
+    return true;
+  }
+
  private:
+  // Parsers that accept a scan cursor get the number of bytes of the pending record that an earlier
+  // attempt already searched, and update it when they fail again, so a record that spans several
+  // reads is scanned once instead of once per read.
+  auto Parse(auto&& parse_func, size_t available) {
+    if constexpr (std::is_invocable_v<decltype(parse_func), uint8_t*, size_t, size_t&>) {
+      auto res = parse_func(&buffer_[buf_pos_], available, scanned_);
+      if (res) scanned_ = 0;
+      return res;
+    } else {
+      return parse_func(&buffer_[buf_pos_], available);
+    }
+  }
+
+  auto Read(size_t space) -> ssize_t {
+    // Sources may keep state of their own (e.g. a decoder), so ReadFromFD is not required to be static.
+    if constexpr (Stats::kTimed) {
+      auto start = std::chrono::steady_clock::now();
+      auto n = static_cast<Derived*>(this)->ReadFromFD(fd_, &buffer_[buf_end_], space);
+      auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+      stats_.OnRead(n, static_cast<uint64_t>(elapsed.count()));
+      return n;
+    } else {
+      auto n = static_cast<Derived*>(this)->ReadFromFD(fd_, &buffer_[buf_end_], space);
+      stats_.OnRead(n, 0);
+      return n;
+    }
+  }
+
+  // Continues in a fresh buffer that starts with the partial record, keeping the current buffer, and
+  // every view into it, alive until Unpin().
+  void SwapBuffer()
+    requires(PinnableBuffer<Buffer>)
+  {
+    auto buffer = Buffer::template make_buffer<kBufferSize + kReservedBytes>();
+    auto rem = buf_end_ - buf_pos_;
+    if constexpr (GrowableBuffer<Buffer>) {
+      // The record may have grown the old buffer beyond the initial size.
+      while (buffer.capacity() < rem && buffer.Grow(0)) {
+      }
+    }
+    stats_.OnReduce(rem);
+    memcpy(&buffer[0], &buffer_[buf_pos_], rem);
+    retired_.push_back(std::exchange(buffer_, std::move(buffer)));
+    buf_pos_ = 0;
+    buf_end_ = rem;
+  }
+
+  static constexpr auto AlignUpTo(size_t size, size_t alignment) -> size_t {
+    return (size + alignment - 1) & ~(alignment - 1);
+  }
+
   static constexpr size_t kBufferSize = Buffer::size;
 
   // String is not null-terminated by default.
   // One extra byte is reserved for user to add null terminator if required.
+  // A wrapping buffer has no room for it: the byte past its end aliases the start.
   static constexpr auto kReservedBytes = [] consteval -> size_t {
-    if constexpr (is_string_view_v<value_type>) {
+    if constexpr (is_string_view_v<value_type> && !WrappingBuffer<Buffer>) {
       return AlignUp<void*>(kBufferSize + sizeof(typename value_type::value_type)) - kBufferSize;
     } else {
       return 0;
     }
   }();
 
+  using buffer_type = Buffer::template type<kBufferSize + kReservedBytes>;
+
   int fd_;
   bool owned_;
   bool eof_{};
+  bool pinned_{};
   size_t buf_pos_{};
   size_t buf_end_{};
-  Buffer::template type<kBufferSize + kReservedBytes> buffer_;
+  size_t scanned_{};
+  [[no_unique_address]] Stats stats_{};
+  buffer_type buffer_;
+  // Buffers filled while pinned, still referenced by the records returned from them.
+  [[no_unique_address]] std::conditional_t<PinnableBuffer<Buffer>, std::vector<buffer_type>, std::tuple<>> retired_;
 };
 }  // namespace internal
 
@@ -253,6 +589,7 @@ struct StackBuffer {
   using type = std::array<uint8_t, kBufferSize>;
 
   static constexpr auto size = kDefaultBufferSize;
+  static constexpr auto kInline = true;
 
   template <size_t kBufferSize = kDefaultBufferSize>
   static constexpr auto make_buffer() -> type<kBufferSize> {
@@ -323,204 +660,992 @@ struct MMapBuffer {
   uint8_t* base_{};
 };
 
-using DefaultStackBuffer = StackBuffer<16 * 1024>;
-using DefaultHeapBuffer = HeapBuffer<32 * 1024>;
-using DefaultMMapBuffer = MMapBuffer<64 * 1024>;
-using DefaultBuffer = DefaultStackBuffer;
-
-struct UTF8 {
-  static constexpr auto LF = internal::FixedString<char>{};
-  static constexpr auto CR = internal::FixedString{"\r"};
-  static constexpr auto CRLF = internal::FixedString{"\r\n"};
-  static constexpr auto SPACE = internal::FixedString{" "};
-};
-
-struct UTF16 {
-  static constexpr auto LF = internal::FixedString<char16_t>{};
-  static constexpr auto CR = internal::FixedString{u"\r"};
-  static constexpr auto CRLF = internal::FixedString{u"\r\n"};
-  static constexpr auto SPACE = internal::FixedString{u" "};
-};
-
-struct UTF32 {
-  static constexpr auto LF = internal::FixedString<char32_t>{};
-  static constexpr auto CR = internal::FixedString{U"\r"};
-  static constexpr auto CRLF = internal::FixedString{U"\r\n"};
-  static constexpr auto SPACE = internal::FixedString{U" "};
-};
-
-static constexpr auto UTF8 = UTF8::LF;
-static constexpr auto UTF16 = UTF16::LF;
-static constexpr auto UTF32 = UTF32::LF;
-
 /**
- * @brief A high-performance, flexible file reader designed for range-based loops.
- *
- * The FileReader class allows iterating over a file line-by-line (or token-by-token)
- * with zero-copy semantics where possible. It supports customizable memory allocation
- * strategies (Stack vs. Heap) and flexible delimiter/encoding handling.
- *
- * The type of the yielded `line` (e.g., std::string_view, std::wstring_view) is
- * automatically deduced based on the provided delimiter's character type.
- *
- * @tparam Buffer Controls how the internal buffer is allocated.
- * Options: DefaultStackBuffer, StackBuffer<Size>, DefaultHeapBuffer, HeapBuffer<Size>.
- * @tparam kDelimiter Defines the separator and the character encoding.
- * Can be a predefined constant (e.g., UTF8::LF) or a string literal.
- *
- * @example **Basic Usage (Buffering Strategies)**
- * @code
- * // 1. Default Stack Buffer (Fastest, suitable for typical line lengths)
- * for (auto line : FileReader<DefaultStackBuffer>{"/path/to/file"}) {
- * // line is std::string_view
- * }
- *
- * // 2. Custom Size Stack Buffer (e.g., 1024 bytes)
- * for (auto line : FileReader<StackBuffer<1024>>{"/path/to/file"}) {}
- *
- * // 3. Default Heap Buffer (Suitable for large files or limited stack environments)
- * for (auto line : FileReader<DefaultHeapBuffer>{"/path/to/file"}) {}
- *
- * // 4. Custom Size Heap Buffer
- * for (auto line : FileReader<HeapBuffer<4096>>{"/path/to/file"}) {}
- * @endcode
- *
- * @example **Custom Delimiters & Encodings**
- * @code
- * // Unix style (LF), explicitly specified
- * for (auto line : FileReader<DefaultStackBuffer, UTF8>{"..."}) {}
- * for (auto line : FileReader<DefaultStackBuffer, UTF8::LF>{"..."}) {}
- *
- * // Windows style (CRLF)
- * for (auto line : FileReader<DefaultStackBuffer, UTF8::CRLF>{"..."}) {}
- *
- * // Mac style (CR)
- * for (auto line : FileReader<DefaultStackBuffer, UTF8::CR>{"..."}) {}
- *
- * // Custom separator (e.g., Space)
- * for (auto line : FileReader<DefaultStackBuffer, UTF8::SPACE>{"..."}) {}
- * @endcode
- *
- * @example **Type Deduction via Literals**
- * The return type of `line` changes based on the delimiter type:
- * @code
- * // 1. char -> std::string_view
- * FileReader<DefaultStackBuffer, "\n">       // Equivalent to UTF8 and UTF8::LF
- * FileReader<DefaultStackBuffer, "\r\n">     // Equivalent to UTF8::CRLF
- *
- * // 2. wchar_t -> std::wstring_view
- * FileReader<DefaultStackBuffer, L"\n">
- *
- * // 3. char8_t (C++20) -> std::u8string_view
- * FileReader<DefaultStackBuffer, u8"\n">
- *
- * // 4. char16_t -> std::u16string_view
- * FileReader<DefaultStackBuffer, u"\r\n">    // Equivalent to UTF16::CRLF
+ * An MMapBuffer whose pages are faulted in up front, by the call that maps it, instead of one page
+ * fault per page on the first pass through the buffer. Worth it for short-lived readers on a cold
+ * path such as JNI_OnLoad, where those faults are a visible share of the time.
  *
- * // 5. char32_t -> std::u32string_view
- * FileReader<DefaultStackBuffer, U"\n">      // Equivalent to UTF32 and UTF32::LF
- * @endcode
+ * Buffers of kHugePageSize or more ask for huge pages: hugetlbfs pages if any are reserved,
+ * transparent huge pages otherwise. Either may be refused, leaving ordinary pages.
  *
- * @warning The returned string_view points to the internal buffer. Do not store
- * the view itself outside the loop iteration, as the buffer content changes or
- * gets overwritten as reading progresses.
+ * The few bytes a reader reserves past the policy size, for a terminator, are kept out of both
+ * decisions: they get a page of their own that is mapped but only faulted in if written, so a
+ * 64 KiB buffer populates 16 pages and a 4 MiB one two huge pages.
  */
-template <internal::BufferPolicy Buffer = DefaultBuffer, internal::FixedString kDelimiter = UTF8::LF>
-  requires(Buffer::size % sizeof(typename decltype(kDelimiter)::value_type) == 0)
-class FileReader : public internal::BaseReader<FileReader<Buffer, kDelimiter>,
-                                               std::basic_string_view<typename decltype(kDelimiter)::value_type>,
-                                               Buffer> {
- public:
-  using char_type = decltype(kDelimiter)::value_type;
-  using string_view_type = std::basic_string_view<char_type>;
+template <size_t kDefaultBufferSize>
+struct PrefaultedMMapBuffer {
+  template <size_t kBufferSize = kDefaultBufferSize>
+  using type = PrefaultedMMapBuffer<kBufferSize>;
 
-  explicit FileReader(int fd) : FileReader::BaseReader{fd, false} {}
+  static constexpr auto size = kDefaultBufferSize;
+  static constexpr size_t kHugePageSize = 2 * 1024 * 1024;
 
-  explicit FileReader(const char* pathname) : FileReader::BaseReader{raw_open(pathname, O_RDONLY | O_CLOEXEC), true} {}
+  template <size_t kBufferSize = kDefaultBufferSize>
+    requires(kBufferSize > 0)
+  static constexpr auto make_buffer() -> type<kBufferSize> {
+    return {};
+  }
 
-  FileReader(int dirfd, const char* pathname)
-      : FileReader::BaseReader{raw_openat(dirfd, pathname, O_RDONLY | O_CLOEXEC), true} {}
+  auto operator[](size_t index) const { return base_[index]; }
+  auto operator[](size_t index) -> auto& { return base_[index]; }
 
-  auto operator++() { return NextLine(); }
+  PrefaultedMMapBuffer(PrefaultedMMapBuffer&& other) noexcept
+      : base_{std::exchange(other.base_, nullptr)}, mapping_size_{std::exchange(other.mapping_size_, 0)} {}
 
-  auto NextLine() -> std::optional<string_view_type> {
-    return this->NextImpl([] [[gnu::always_inline]] (
-                              const uint8_t* buf,
-                              size_t available) -> std::optional<std::pair<string_view_type, size_t>> {
-      if (!available) [[unlikely]] {
-        return {};
-      }
+  auto operator=(PrefaultedMMapBuffer&& other) noexcept -> auto& {
+    if (this != &other) {
+      if (base_) raw_munmap(base_, mapping_size_);
+      base_ = std::exchange(other.base_, nullptr);
+      mapping_size_ = std::exchange(other.mapping_size_, 0);
+    }
+    return *this;
+  }
+
+  PrefaultedMMapBuffer() {
+    if constexpr (kPopulateSize >= kHugePageSize) {
+      if (MapHugeTlb()) return;
 
-      if constexpr (sizeof(char_type) > 1) {
-        available = internal::AlignDown<char_type>(available);
-        if (!available) [[unlikely]] {
-          return {};
+      // Transparent huge pages need a huge page aligned range, and have to be asked for before the
+      // pages are populated. Map a huge page more than needed and trim it to an aligned start.
+      auto base = raw_mmap(nullptr, kMappedSize + kHugePageSize, kProt, kFlags, -1, 0);
+      if (reinterpret_cast<uintptr_t>(base) >= -4095UL) [[unlikely]] {
+        return;
+      }
+      auto start = reinterpret_cast<uintptr_t>(base);
+      auto aligned = (start + kHugePageSize - 1) & ~(kHugePageSize - 1);
+      if (aligned > start) raw_munmap(base, aligned - start);
+      raw_munmap(reinterpret_cast<void*>(aligned + kMappedSize), start + kHugePageSize - aligned);
+      base_ = reinterpret_cast<uint8_t*>(aligned);
+      mapping_size_ = kMappedSize;
+      raw_madvise(base_, kPopulateSize, MADV_HUGEPAGE);
+      if (raw_madvise(base_, kPopulateSize, kMadvPopulateWrite) < 0) [[unlikely]] {
+        // Before Linux 5.14: touch every page instead.
+        for (size_t i = 0; i < kPopulateSize; i += kMinPageSize) {
+          static_cast<volatile uint8_t*>(base_)[i] = 0;
         }
       }
-
-      const void* next = nullptr;
-      if constexpr (!std::is_same_v<char_type, char>) {
-        auto sv = string_view_type{reinterpret_cast<const char_type*>(buf),
-                                   reinterpret_cast<const char_type*>(buf + available)};
-        auto pos = string_view_type::npos;
-        if constexpr (kDelimiter.empty()) {
-          pos = sv.find(kDefaultDelimiter);
-        } else if constexpr (kDelimiter.size() == 1) {
-          pos = sv.find(*kDelimiter);
-        } else {
-          pos = sv.find(kDelimiter.data(), 0, kDelimiter.size());
+    } else {
+      if constexpr (kPopulateSize < kMappedSize) {
+        // Map the whole buffer unpopulated, then populate the pages before the terminator page.
+        auto base = raw_mmap(nullptr, kMappedSize, kProt, kFlags, -1, 0);
+        if (reinterpret_cast<uintptr_t>(base) >= -4095UL) [[unlikely]] {
+          return;
         }
-        if (pos != string_view_type::npos) [[likely]] {
-          next = reinterpret_cast<const char_type*>(buf) + pos;
+        raw_munmap(base, kPopulateSize);
+        if (MapAt(base, kPopulateSize, MAP_POPULATE)) [[likely]] {
+          base_ = static_cast<uint8_t*>(base);
+          mapping_size_ = kMappedSize;
+          return;
         }
-      } else if constexpr (kDelimiter.empty()) {
-        next = memchr(buf, kDefaultDelimiter, available);
-      } else if constexpr (kDelimiter.size() == 1) {
-        next = memchr(buf, *kDelimiter, available);
-      } else {
-        next = memmem(buf, available, kDelimiter.data(), kDelimiter.size());
+        raw_munmap(static_cast<uint8_t*>(base) + kPopulateSize, kMappedSize - kPopulateSize);
       }
-
-      if (next) [[likely]] {
-        auto len = static_cast<size_t>(static_cast<const char_type*>(next) - reinterpret_cast<const char_type*>(buf));
-        return std::pair{string_view_type{reinterpret_cast<const char_type*>(buf), len},
-                         (len + std::max<size_t>(kDelimiter.size(), 1)) * sizeof(char_type)};
+      auto base = raw_mmap(nullptr, kMappedSize, kProt, kFlags | MAP_POPULATE, -1, 0);
+      if (reinterpret_cast<uintptr_t>(base) < -4095UL) [[likely]] {
+        base_ = static_cast<uint8_t*>(base);
+        mapping_size_ = kMappedSize;
       }
-      return {};
-    });
-  }
-
- private:
-  static constexpr auto kDefaultDelimiter = [] consteval {
-    if constexpr (std::is_same_v<char_type, char>) {
-      return '\n';
-    } else if constexpr (std::is_same_v<char_type, wchar_t>) {
-      return L'\n';
-    } else if constexpr (std::is_same_v<char_type, char8_t>) {
-      return u8'\n';
-    } else if constexpr (std::is_same_v<char_type, char16_t>) {
-      return u'\n';
-    } else if constexpr (std::is_same_v<char_type, char32_t>) {
-      return U'\n';
     }
-  }();
-
-  static auto OnBufferFull(const uint8_t* buf, size_t sz) -> std::optional<string_view_type> {
-    return string_view_type{reinterpret_cast<const char_type*>(buf),
-                            reinterpret_cast<const char_type*>(buf + internal::AlignDown<char_type>(sz))};
   }
 
-  static auto OnEOF(const uint8_t* buf, size_t sz) -> std::optional<string_view_type> {
-    sz = internal::AlignDown<char_type>(sz);
-    if (sz == 0) return {};
-    return string_view_type{reinterpret_cast<const char_type*>(buf), reinterpret_cast<const char_type*>(buf + sz)};
+  ~PrefaultedMMapBuffer() {
+    if (base_) [[likely]] {
+      raw_munmap(base_, mapping_size_);
+    }
   }
 
-  static auto ReadFromFD(int fd, void* buf, size_t sz) { return raw_read(fd, buf, sz); }
+  PrefaultedMMapBuffer(const PrefaultedMMapBuffer&) = delete;
+  void operator=(const PrefaultedMMapBuffer&) = delete;
+
+ private:
+  static constexpr auto kProt = PROT_READ | PROT_WRITE;
+  static constexpr auto kFlags = MAP_PRIVATE | MAP_ANONYMOUS;
+  // MAP_HUGE_2MB, MAP_FIXED_NOREPLACE and MADV_POPULATE_WRITE, which older headers lack.
+  static constexpr int kMapHuge2MB = 21 << 26;
+  static constexpr int kMapFixedNoReplace = 0x100000;
+  static constexpr int kMadvPopulateWrite = 23;
+  static constexpr size_t kMinPageSize = 4096;
+  // Longest tail past the policy size that BaseReader reserves.
+  static constexpr size_t kMaxReservedBytes = 2 * sizeof(void*);
+
+  static constexpr size_t kMappedSize = (kDefaultBufferSize + kMinPageSize - 1) & ~(kMinPageSize - 1);
+  // Whole pages, unless the last partial page holds more than the reserved tail.
+  static constexpr size_t kPopulateSize =
+      kDefaultBufferSize > kMinPageSize && kDefaultBufferSize % kMinPageSize <= kMaxReservedBytes
+          ? kDefaultBufferSize & ~(kMinPageSize - 1)
+          : kMappedSize;
+
+  // Maps `size` bytes at `addr`, which the caller has just unmapped. Fails if another thread took
+  // the range in between.
+  static auto MapAt(void* addr, size_t size, int flags) -> bool {
+    // Kernels before 4.17 take the flag as a hint and may place the pages elsewhere.
+    auto mapped = raw_mmap(addr, size, kProt, kFlags | kMapFixedNoReplace | flags, -1, 0);
+    if (mapped == addr) [[likely]] {
+      return true;
+    }
+    if (reinterpret_cast<uintptr_t>(mapped) < -4095UL) raw_munmap(mapped, size);
+    return false;
+  }
+
+  // Populated hugetlbfs pages, followed by an ordinary terminator page if the tail does not fit.
+  auto MapHugeTlb() -> bool {
+    constexpr auto kHugeSize = (kPopulateSize + kHugePageSize - 1) & ~(kHugePageSize - 1);
+    constexpr auto kSize = std::max(kHugeSize, kMappedSize);
+    // Reserve an unpopulated range with room to align it, and put the huge pages in its aligned start.
+    auto base = raw_mmap(nullptr, kSize + kHugePageSize, kProt, kFlags, -1, 0);
+    if (reinterpret_cast<uintptr_t>(base) >= -4095UL) [[unlikely]] {
+      return false;
+    }
+    auto start = reinterpret_cast<uintptr_t>(base);
+    auto end = start + kSize + kHugePageSize;
+    auto aligned = (start + kHugePageSize - 1) & ~(kHugePageSize - 1);
+    if (aligned > start) raw_munmap(base, aligned - start);
+    raw_munmap(reinterpret_cast<void*>(aligned), kHugeSize);
+    if (!MapAt(reinterpret_cast<void*>(aligned), kHugeSize, MAP_HUGETLB | kMapHuge2MB | MAP_POPULATE)) {
+      raw_munmap(reinterpret_cast<void*>(aligned + kHugeSize), end - aligned - kHugeSize);
+      return false;
+    }
+    raw_munmap(reinterpret_cast<void*>(aligned + kSize), end - aligned - kSize);
+    base_ = reinterpret_cast<uint8_t*>(aligned);
+    mapping_size_ = kSize;
+    return true;
+  }
+
+  uint8_t* base_{};
+  size_t mapping_size_{};
+};
+
+/**
+ * A ring buffer backed by a memfd that is mapped twice back to back. A record that wraps around
+ * the end of the ring reads contiguously through the second mapping, so BaseReader never has to
+ * move a partial record to the front of the buffer.
+ *
+ * The size must be a multiple of the largest page size Android uses (16 KiB). Unlike the other
+ * policies there is no spare byte after a record for a null terminator.
+ */
+template <size_t kDefaultBufferSize>
+  requires(kDefaultBufferSize % (16 * 1024) == 0)
+struct RingBuffer {
+  template <size_t kBufferSize = kDefaultBufferSize>
+  using type = RingBuffer<kBufferSize>;
+
+  static constexpr auto size = kDefaultBufferSize;
+  static constexpr auto kWrapsAround = true;
+
+  template <size_t kBufferSize = kDefaultBufferSize>
+    requires(kBufferSize > 0)
+  static constexpr auto make_buffer() -> type<kBufferSize> {
+    return {};
+  }
+
+  auto operator[](size_t index) const { return base_[index]; }
+  auto operator[](size_t index) -> auto& { return base_[index]; }
+
+  RingBuffer(RingBuffer&& other) noexcept : base_{std::exchange(other.base_, nullptr)} {}
+
+  auto operator=(RingBuffer&& other) noexcept -> auto& {
+    if (this != &other) {
+      if (base_) raw_munmap(base_, kDefaultBufferSize * 2);
+      base_ = std::exchange(other.base_, nullptr);
+    }
+    return *this;
+  }
+
+  RingBuffer() {
+    auto base = raw_mmap(nullptr, kDefaultBufferSize * 2, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reinterpret_cast<uintptr_t>(base) >= -4095UL) [[unlikely]] {
+      return;
+    }
+    auto lower = static_cast<uint8_t*>(base);
+    auto upper = lower + kDefaultBufferSize;
+
+    if (MapTwice(lower, upper)) [[likely]] {
+      base_ = lower;
+    } else {
+      raw_munmap(base, kDefaultBufferSize * 2);
+    }
+  }
+
+  ~RingBuffer() {
+    if (base_) [[likely]] {
+      raw_munmap(base_, kDefaultBufferSize * 2);
+    }
+  }
+
+  RingBuffer(const RingBuffer&) = delete;
+  void operator=(const RingBuffer&) = delete;
+
+ private:
+  static auto MapTwice(uint8_t* lower, uint8_t* upper) -> bool {
+    constexpr auto kProt = PROT_READ | PROT_WRITE;
+    constexpr auto kFlags = MAP_SHARED | MAP_FIXED;
+
+    if (auto fd = raw_memfd_create("io_ring_buffer", MFD_CLOEXEC); fd >= 0) [[likely]] {
+      auto ok = raw_ftruncate(fd, kDefaultBufferSize) >= 0 &&
+                reinterpret_cast<uintptr_t>(raw_mmap(lower, kDefaultBufferSize, kProt, kFlags, fd, 0)) < -4095UL &&
+                reinterpret_cast<uintptr_t>(raw_mmap(upper, kDefaultBufferSize, kProt, kFlags, fd, 0)) < -4095UL;
+      raw_close(fd);
+      if (ok) return true;
+    }
+
+    // memfd_create may be filtered; mremap with old_size 0 duplicates a shared anonymous mapping instead.
+    if (reinterpret_cast<uintptr_t>(raw_mmap(lower, kDefaultBufferSize, kProt, kFlags | MAP_ANONYMOUS, -1, 0)) >=
+        -4095UL) [[unlikely]] {
+      return false;
+    }
+    auto mirror = raw_mremap(lower, 0, kDefaultBufferSize, MREMAP_MAYMOVE | MREMAP_FIXED, upper);
+    return mirror == upper;
+  }
+
+  uint8_t* base_{};
+};
+
+/**
+ * A page-aligned buffer for reading with O_DIRECT, which bypasses the page cache: scanning a large
+ * apk or oat file this way does not evict the pages the rest of the process is using.
+ *
+ * FileReader opens files with O_DIRECT when given this policy and keeps every read aligned to
+ * kDirectIOAlignment, the largest logical block size of Android storage. Files on filesystems
+ * without O_DIRECT support are read through the page cache as usual.
+ *
+ * @code
+ * for (auto line : FileReader<AlignedDirectBuffer<256 * 1024>>{"/data/app/.../base.apk"}) {}
+ * @endcode
+ *
+ * @note Direct reads go to the device every time: use this for one-off bulk scans, not for
+ * small or hot files. Lines longer than the buffer come out in pieces of up to one block more
+ * than its size.
+ */
+template <size_t kDefaultBufferSize, size_t kAllocSize = kDefaultBufferSize>
+  requires(kDefaultBufferSize % 4096 == 0 && kAllocSize >= kDefaultBufferSize)
+struct AlignedDirectBuffer {
+  template <size_t kBufferSize = kDefaultBufferSize>
+  using type = AlignedDirectBuffer<kDefaultBufferSize, kBufferSize>;
+
+  static constexpr auto size = kDefaultBufferSize;
+  static constexpr size_t kDirectIOAlignment = 4096;
+
+  template <size_t kBufferSize = kDefaultBufferSize>
+  static constexpr auto make_buffer() -> type<kBufferSize> {
+    return {};
+  }
+
+  auto operator[](size_t index) const { return base_[index]; }
+  auto operator[](size_t index) -> auto& { return base_[index]; }
+
+  AlignedDirectBuffer(AlignedDirectBuffer&& other) noexcept : base_{std::exchange(other.base_, nullptr)} {}
+
+  auto operator=(AlignedDirectBuffer&& other) noexcept -> auto& {
+    if (this != &other) {
+      if (base_) raw_munmap(base_, kMappingSize);
+      base_ = std::exchange(other.base_, nullptr);
+    }
+    return *this;
+  }
+
+  // Anonymous mappings are page aligned, which covers kDirectIOAlignment with any page size.
+  AlignedDirectBuffer() {
+    auto base = raw_mmap(nullptr, kMappingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (reinterpret_cast<uintptr_t>(base) < -4095UL) [[likely]] {
+      base_ = static_cast<uint8_t*>(base);
+    }
+  }
+
+  ~AlignedDirectBuffer() {
+    if (base_) [[likely]] {
+      raw_munmap(base_, kMappingSize);
+    }
+  }
+
+  AlignedDirectBuffer(const AlignedDirectBuffer&) = delete;
+  void operator=(const AlignedDirectBuffer&) = delete;
+
+ private:
+  // One more block than asked for, so that a record of up to kDefaultBufferSize bytes stays whole
+  // after BaseReader::Reduce aligns its end.
+  static constexpr size_t kMappingSize = kAllocSize + kDirectIOAlignment;
+
+  uint8_t* base_{};
+};
+
+struct BufferGrowthStats {
+  // Number of times a buffer had to be enlarged to keep a record whole.
+  uint64_t growths;
+  // Largest capacity any buffer of the policy reached.
+  uint64_t peak_capacity;
+  // Records that were still split because the buffer had reached its maximum size.
+  uint64_t capped;
+};
+
+namespace internal {
+// Counters are kept per policy, shared by every allocation size the policy is instantiated with.
+template <size_t kInitialSize, size_t kMaxSize>
+struct BufferGrowthCounters {
+  static inline std::atomic<uint64_t> growths{};
+  static inline std::atomic<uint64_t> peak_capacity{kInitialSize};
+  static inline std::atomic<uint64_t> capped{};
+
+  [[nodiscard]] static auto Get() -> BufferGrowthStats {
+    return {
+        .growths = growths.load(std::memory_order_relaxed),
+        .peak_capacity = peak_capacity.load(std::memory_order_relaxed),
+        .capped = capped.load(std::memory_order_relaxed),
+    };
+  }
+};
+}  // namespace internal
+
+/**
+ * A heap buffer that doubles its capacity whenever a single record does not fit, up to
+ * `kMaxBufferSize`. Records are only split (as with the fixed policies) once that cap is reached.
+ *
+ * Growth is recorded per policy instantiation; check `stats()` on production data to pick an
+ * initial size that rarely grows.
+ *
+ * @code
+ * using SMapsBuffer = GrowableHeapBuffer<4096, 1024 * 1024>;
+ * for (auto line : FileReader<SMapsBuffer>{"/proc/self/smaps"}) {}
+ * auto [growths, peak, capped] = SMapsBuffer::stats();
+ * @endcode
+ *
+ * @warning Growing moves the buffered data: like a refill, it invalidates earlier views.
+ */
+template <size_t kDefaultBufferSize, size_t kMaxBufferSize = 1024 * 1024, size_t kAllocSize = kDefaultBufferSize>
+  requires(kMaxBufferSize >= kDefaultBufferSize && kAllocSize >= kDefaultBufferSize)
+struct GrowableHeapBuffer {
+  template <size_t kBufferSize = kDefaultBufferSize>
+  using type = GrowableHeapBuffer<kDefaultBufferSize, kMaxBufferSize, kBufferSize>;
+
+  static constexpr auto size = kDefaultBufferSize;
+  static constexpr auto kGrowable = true;
+
+  template <size_t kBufferSize = kDefaultBufferSize>
+  static constexpr auto make_buffer() -> type<kBufferSize> {
+    return {};
+  }
+
+  [[nodiscard]] static auto stats() -> BufferGrowthStats { return Counters::Get(); }
+
+  auto operator[](size_t index) const { return data_[index]; }
+  auto operator[](size_t index) -> auto& { return data_[index]; }
+
+  GrowableHeapBuffer() : data_{std::make_unique<uint8_t[]>(kAllocSize)} {}
+
+  GrowableHeapBuffer(GrowableHeapBuffer&& other) noexcept
+      : data_{std::move(other.data_)}, capacity_{std::exchange(other.capacity_, kDefaultBufferSize)} {}
+
+  auto operator=(GrowableHeapBuffer&& other) noexcept -> auto& {
+    if (this != &other) {
+      data_ = std::move(other.data_);
+      capacity_ = std::exchange(other.capacity_, kDefaultBufferSize);
+    }
+    return *this;
+  }
+
+  GrowableHeapBuffer(const GrowableHeapBuffer&) = delete;
+  void operator=(const GrowableHeapBuffer&) = delete;
+
+  // Usable bytes, excluding the bytes the reader reserved on top of the policy size.
+  [[nodiscard]] auto capacity() const noexcept { return capacity_; }
+
+  // Doubles the capacity, keeping the first `used` bytes. Returns false once the cap is reached.
+  auto Grow(size_t used) -> bool {
+    if (capacity_ >= kMaxBufferSize) [[unlikely]] {
+      Counters::capped.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    auto capacity = std::min(capacity_ * 2, kMaxBufferSize);
+    auto data = std::unique_ptr<uint8_t[]>{new uint8_t[capacity + kReservedBytes]};
+    memcpy(data.get(), data_.get(), used);
+    data_ = std::move(data);
+    capacity_ = capacity;
+
+    Counters::growths.fetch_add(1, std::memory_order_relaxed);
+    for (auto peak = Counters::peak_capacity.load(std::memory_order_relaxed);
+         peak < capacity && !Counters::peak_capacity.compare_exchange_weak(peak, capacity, std::memory_order_relaxed);) {
+    }
+    return true;
+  }
+
+ private:
+  using Counters = internal::BufferGrowthCounters<kDefaultBufferSize, kMaxBufferSize>;
+
+  static constexpr size_t kReservedBytes = kAllocSize - kDefaultBufferSize;
+
+  std::unique_ptr<uint8_t[]> data_;
+  size_t capacity_{kDefaultBufferSize};
+};
+
+using DefaultStackBuffer = StackBuffer<16 * 1024>;
+using DefaultHeapBuffer = HeapBuffer<32 * 1024>;
+using DefaultMMapBuffer = MMapBuffer<64 * 1024>;
+using DefaultPrefaultedMMapBuffer = PrefaultedMMapBuffer<64 * 1024>;
+using DefaultRingBuffer = RingBuffer<64 * 1024>;
+using DefaultDirectBuffer = AlignedDirectBuffer<256 * 1024>;
+using DefaultBuffer = DefaultStackBuffer;
+
+/**
+ * Builds a delimiter that matches any one of the given code units instead of the whole sequence.
+ *
+ * @code
+ * for (auto token : FileReader<DefaultStackBuffer, AnyOf(" \t")>{"..."}) {}
+ * @endcode
+ */
+template <typename T, size_t N>
+  requires(N > 1)
+consteval auto AnyOf(const T (&data)[N]) {
+  auto result = internal::FixedString<T, N>{data};
+  result.any_of_ = true;
+  return result;
+}
+
+struct UTF8 {
+  static constexpr auto LF = internal::FixedString<char>{};
+  static constexpr auto CR = internal::FixedString{"\r"};
+  static constexpr auto CRLF = internal::FixedString{"\r\n"};
+  static constexpr auto SPACE = internal::FixedString{" "};
+  static constexpr auto BLANK = AnyOf(" \t");
+};
+
+struct UTF16 {
+  static constexpr auto LF = internal::FixedString<char16_t>{};
+  static constexpr auto CR = internal::FixedString{u"\r"};
+  static constexpr auto CRLF = internal::FixedString{u"\r\n"};
+  static constexpr auto SPACE = internal::FixedString{u" "};
+  static constexpr auto BLANK = AnyOf(u" \t");
+};
+
+struct UTF32 {
+  static constexpr auto LF = internal::FixedString<char32_t>{};
+  static constexpr auto CR = internal::FixedString{U"\r"};
+  static constexpr auto CRLF = internal::FixedString{U"\r\n"};
+  static constexpr auto SPACE = internal::FixedString{U" "};
+  static constexpr auto BLANK = AnyOf(U" \t");
+};
+
+static constexpr auto UTF8 = UTF8::LF;
+static constexpr auto UTF16 = UTF16::LF;
+static constexpr auto UTF32 = UTF32::LF;
+
+namespace internal {
+template <FixedString kDelimiter>
+struct LineSplitter {
+  using char_type = decltype(kDelimiter)::value_type;
+  using string_view_type = std::basic_string_view<char_type>;
+  using result_type = std::optional<std::pair<string_view_type, size_t>>;
+
+  static constexpr auto kDefaultDelimiter = [] consteval {
+    if constexpr (std::is_same_v<char_type, char>) {
+      return '\n';
+    } else if constexpr (std::is_same_v<char_type, wchar_t>) {
+      return L'\n';
+    } else if constexpr (std::is_same_v<char_type, char8_t>) {
+      return u8'\n';
+    } else if constexpr (std::is_same_v<char_type, char16_t>) {
+      return u'\n';
+    } else if constexpr (std::is_same_v<char_type, char32_t>) {
+      return U'\n';
+    }
+  }();
+
+  // Number of code units the delimiter occupies in the input.
+  static constexpr size_t kLength = kDelimiter.is_any_of() ? 1 : std::max<size_t>(kDelimiter.size(), 1);
+
+  // Invokes `func` with the delimiter's code units as a template parameter pack.
+  [[gnu::always_inline]] static auto Expand(auto&& func) {
+    return [&]<size_t... I> [[gnu::always_inline]] (std::index_sequence<I...>) {
+      return func.template operator()<kDelimiter[I]...>();
+    }(std::make_index_sequence<kDelimiter.size()>{});
+  }
+
+  // Returns the first delimited record in `buf` together with the number of bytes it consumes
+  // (delimiter included), or nothing if `buf` holds no complete record.
+  [[gnu::always_inline]] static auto Split(const uint8_t* buf, size_t available) -> result_type {
+    size_t scanned = 0;
+    return Split(buf, available, scanned);
+  }
+
+  // Same as above, but skips the first `scanned` bytes that an earlier call already searched in
+  // vain. On failure `scanned` is advanced to where the next call may resume.
+  [[gnu::always_inline]] static auto Split(const uint8_t* buf, size_t available, size_t& scanned) -> result_type {
+    if (!available) [[unlikely]] {
+      return {};
+    }
+
+    if constexpr (sizeof(char_type) > 1) {
+      available = AlignDown<char_type>(available);
+      if (!available) [[unlikely]] {
+        return {};
+      }
+    }
+
+    // Wide code units go through the same vector kernels, comparing whole 16/32-bit lanes.
+    const void* next = nullptr;
+    auto p = reinterpret_cast<const char_type*>(buf) + std::min(scanned, available) / sizeof(char_type);
+    auto n = (available - std::min(scanned, available)) / sizeof(char_type);
+    if constexpr (kDelimiter.empty()) {
+      if constexpr (sizeof(char_type) == 1) {
+        next = memchr(p, kDefaultDelimiter, n);
+      } else {
+        next = FindAnyOf<char_type, kDefaultDelimiter>(p, n);
+      }
+    } else if constexpr (kDelimiter.is_any_of()) {
+      next = Expand([&]<char_type... kSet> { return FindAnyOf<char_type, kSet...>(p, n); });
+    } else if constexpr (kDelimiter.size() == 1) {
+      if constexpr (sizeof(char_type) == 1) {
+        next = memchr(p, *kDelimiter, n);
+      } else {
+        next = FindAnyOf<char_type, *kDelimiter>(p, n);
+      }
+    } else {
+      next = Expand([&]<char_type... kSeq> { return FindSequence<char_type, kSeq...>(p, n); });
+    }
+
+    if (next) [[likely]] {
+      auto len = static_cast<size_t>(static_cast<const char_type*>(next) - reinterpret_cast<const char_type*>(buf));
+      return std::pair{string_view_type{reinterpret_cast<const char_type*>(buf), len}, (len + kLength) * sizeof(char_type)};
+    }
+    // A multi-unit delimiter may straddle the end of the data, so its head has to be searched again.
+    scanned = available > (kLength - 1) * sizeof(char_type) ? available - (kLength - 1) * sizeof(char_type) : 0;
+    return {};
+  }
+
+  // Returns the offset of the last record in `buf`, the one after the last delimiter, or nothing if
+  // `buf` holds no delimiter. Used to split from the end of the input.
+  [[gnu::always_inline]] static auto SplitLast(const uint8_t* buf, size_t available) -> std::optional<size_t> {
+    auto p = reinterpret_cast<const char_type*>(buf);
+    auto n = AlignDown<char_type>(available) / sizeof(char_type);
+    const char_type* last = nullptr;
+    if constexpr (kDelimiter.empty()) {
+      last = FindLastAnyOf<char_type, kDefaultDelimiter>(p, n);
+    } else if constexpr (kDelimiter.is_any_of() || kDelimiter.size() == 1) {
+      last = Expand([&]<char_type... kSet> { return FindLastAnyOf<char_type, kSet...>(p, n); });
+    } else {
+      last = Expand([&]<char_type... kSeq> { return FindLastSequence<char_type, kSeq...>(p, n); });
+    }
+    if (!last) return {};
+    return static_cast<size_t>(last - p + kLength) * sizeof(char_type);
+  }
+
+  // Whether `buf` ends with a delimiter, i.e. the input has no unterminated last record.
+  static auto EndsWithDelimiter(const uint8_t* buf, size_t sz) -> bool {
+    sz = AlignDown<char_type>(sz);
+    if (sz < kLength * sizeof(char_type)) return false;
+    auto start = buf + sz - kLength * sizeof(char_type);
+    return SplitLast(start, kLength * sizeof(char_type)) == kLength * sizeof(char_type);
+  }
+
+  // Returns whatever whole code units are left in `buf`, used for the last record of the input.
+  static auto Tail(const uint8_t* buf, size_t sz) -> std::optional<string_view_type> {
+    sz = AlignDown<char_type>(sz);
+    if (sz == 0) return {};
+    return string_view_type{reinterpret_cast<const char_type*>(buf), reinterpret_cast<const char_type*>(buf + sz)};
+  }
+};
+}  // namespace internal
+
+/**
+ * @brief A high-performance, flexible file reader designed for range-based loops.
+ *
+ * The FileReader class allows iterating over a file line-by-line (or token-by-token)
+ * with zero-copy semantics where possible. It supports customizable memory allocation
+ * strategies (Stack vs. Heap) and flexible delimiter/encoding handling.
+ *
+ * The type of the yielded `line` (e.g., std::string_view, std::wstring_view) is
+ * automatically deduced based on the provided delimiter's character type.
+ *
+ * @tparam Buffer Controls how the internal buffer is allocated.
+ * Options: DefaultStackBuffer, StackBuffer<Size>, DefaultHeapBuffer, HeapBuffer<Size>,
+ * DefaultMMapBuffer, MMapBuffer<Size>, DefaultPrefaultedMMapBuffer, PrefaultedMMapBuffer<Size>,
+ * DefaultRingBuffer, RingBuffer<Size>, GrowableHeapBuffer<InitialSize, MaxSize>,
+ * DefaultDirectBuffer, AlignedDirectBuffer<Size> (opens with O_DIRECT).
+ * @tparam kDelimiter Defines the separator and the character encoding.
+ * Can be a predefined constant (e.g., UTF8::LF) or a string literal.
+ * @tparam Stats Instrumentation policy: NoStats (default, free), CountingStats or ChecksumStats
+ * (checksum.h), read with GetStats().
+ *
+ * @example **Basic Usage (Buffering Strategies)**
+ * @code
+ * // 1. Default Stack Buffer (Fastest, suitable for typical line lengths)
+ * for (auto line : FileReader<DefaultStackBuffer>{"/path/to/file"}) {
+ * // line is std::string_view
+ * }
+ *
+ * // 2. Custom Size Stack Buffer (e.g., 1024 bytes)
+ * for (auto line : FileReader<StackBuffer<1024>>{"/path/to/file"}) {}
+ *
+ * // 3. Default Heap Buffer (Suitable for large files or limited stack environments)
+ * for (auto line : FileReader<DefaultHeapBuffer>{"/path/to/file"}) {}
+ *
+ * // 4. Custom Size Heap Buffer
+ * for (auto line : FileReader<HeapBuffer<4096>>{"/path/to/file"}) {}
+ * @endcode
+ *
+ * @example **Custom Delimiters & Encodings**
+ * @code
+ * // Unix style (LF), explicitly specified
+ * for (auto line : FileReader<DefaultStackBuffer, UTF8>{"..."}) {}
+ * for (auto line : FileReader<DefaultStackBuffer, UTF8::LF>{"..."}) {}
+ *
+ * // Windows style (CRLF)
+ * for (auto line : FileReader<DefaultStackBuffer, UTF8::CRLF>{"..."}) {}
+ *
+ * // Mac style (CR)
+ * for (auto line : FileReader<DefaultStackBuffer, UTF8::CR>{"..."}) {}
+ *
+ * // Custom separator (e.g., Space)
+ * for (auto line : FileReader<DefaultStackBuffer, UTF8::SPACE>{"..."}) {}
+ *
+ * // Any of a set of separators (e.g., Space or Tab)
+ * for (auto line : FileReader<DefaultStackBuffer, UTF8::BLANK>{"..."}) {}
+ * for (auto line : FileReader<DefaultStackBuffer, AnyOf(",;")>{"..."}) {}
+ * @endcode
+ *
+ * @example **Type Deduction via Literals**
+ * The return type of `line` changes based on the delimiter type:
+ * @code
+ * // 1. char -> std::string_view
+ * FileReader<DefaultStackBuffer, "\n">       // Equivalent to UTF8 and UTF8::LF
+ * FileReader<DefaultStackBuffer, "\r\n">     // Equivalent to UTF8::CRLF
+ *
+ * // 2. wchar_t -> std::wstring_view
+ * FileReader<DefaultStackBuffer, L"\n">
+ *
+ * // 3. char8_t (C++20) -> std::u8string_view
+ * FileReader<DefaultStackBuffer, u8"\n">
+ *
+ * // 4. char16_t -> std::u16string_view
+ * FileReader<DefaultStackBuffer, u"\r\n">    // Equivalent to UTF16::CRLF
+ *
+ * // 5. char32_t -> std::u32string_view
+ * FileReader<DefaultStackBuffer, U"\n">      // Equivalent to UTF32 and UTF32::LF
+ * @endcode
+ *
+ * @warning The returned string_view points to the internal buffer. Do not store
+ * the view itself outside the loop iteration, as the buffer content changes or
+ * gets overwritten as reading progresses.
+ */
+template <internal::BufferPolicy Buffer = DefaultBuffer, internal::FixedString kDelimiter = UTF8::LF,
+          internal::StatsPolicy Stats = NoStats>
+  requires(Buffer::size % sizeof(typename decltype(kDelimiter)::value_type) == 0)
+class FileReader : public internal::BaseReader<FileReader<Buffer, kDelimiter, Stats>,
+                                               std::basic_string_view<typename decltype(kDelimiter)::value_type>,
+                                               Buffer,
+                                               Stats> {
+ public:
+  using char_type = decltype(kDelimiter)::value_type;
+  using string_view_type = std::basic_string_view<char_type>;
+
+  explicit FileReader(int fd) : FileReader::BaseReader{fd, false} {}
+
+  explicit FileReader(const char* pathname) : FileReader::BaseReader{Open(AT_FDCWD, pathname), true} {}
+
+  FileReader(int dirfd, const char* pathname) : FileReader::BaseReader{Open(dirfd, pathname), true} {}
+
+  auto operator++() { return NextLine(); }
+
+  auto NextLine() -> std::optional<string_view_type> {
+    return this->NextImpl([] [[gnu::always_inline]] (const uint8_t* buf, size_t available, size_t& scanned) {
+      return Splitter::Split(buf, available, scanned);
+    });
+  }
+
+  /**
+   * Reads up to `out.size()` lines at once: the next line, plus every complete line that is
+   * already buffered behind it. Returns the number of lines written, 0 at end of file.
+   *
+   * @code
+   * std::array<std::string_view, 64> lines;
+   * while (auto n = reader.NextLines(lines)) {
+   *   for (auto line : std::span{lines}.first(n)) {}
+   * }
+   * @endcode
+   *
+   * @warning The views share one buffer fill and are invalidated by the next NextLine/NextLines call.
+   */
+  auto NextLines(std::span<string_view_type> out) -> size_t {
+    return this->NextBatchImpl(out, [] [[gnu::always_inline]] (const uint8_t* buf, size_t available, size_t& scanned) {
+      return Splitter::Split(buf, available, scanned);
+    });
+  }
+
+  /**
+   * Moves the file position to line `line` (0-based) of a LineIndex built for this file, so the
+   * next NextLine returns it. Fails on unseekable files and lines past the end of the index.
+   *
+   * @warning Previously returned views are invalidated.
+   */
+  auto SeekToLine(const auto& index, size_t line) -> bool {
+    auto offset = index.Offset(line);
+    if (!offset) [[unlikely]] {
+      return false;
+    }
+    if constexpr (internal::DirectBuffer<Buffer>) {
+      // O_DIRECT reads start on a block boundary: read from there and drop the head of the block.
+      auto aligned = *offset & ~static_cast<uint64_t>(Buffer::kDirectIOAlignment - 1);
+      if (raw_lseek(this->GetFd(), static_cast<off_t>(aligned), SEEK_SET) < 0) [[unlikely]] {
+        return false;
+      }
+      this->ResetBuffer();
+      return this->Discard(static_cast<size_t>(*offset - aligned));
+    } else {
+      if (raw_lseek(this->GetFd(), static_cast<off_t>(*offset), SEEK_SET) < 0) [[unlikely]] {
+        return false;
+      }
+      this->ResetBuffer();
+      return true;
+    }
+  }
+
+ private:
+  using Splitter = internal::LineSplitter<kDelimiter>;
+
+  static auto Open(int dirfd, const char* pathname) -> int {
+    if constexpr (internal::DirectBuffer<Buffer>) {
+      // Filesystems without O_DIRECT support reject it with EINVAL; read those through the page cache.
+      if (auto fd = raw_openat(dirfd, pathname, O_RDONLY | O_CLOEXEC | O_DIRECT); fd != -EINVAL) {
+        return fd;
+      }
+    }
+    return raw_openat(dirfd, pathname, O_RDONLY | O_CLOEXEC);
+  }
+
+  static auto OnBufferFull(const uint8_t* buf, size_t sz) -> std::optional<string_view_type> {
+    return string_view_type{reinterpret_cast<const char_type*>(buf),
+                            reinterpret_cast<const char_type*>(buf + internal::AlignDown<char_type>(sz))};
+  }
+
+  static auto OnEOF(const uint8_t* buf, size_t sz) -> std::optional<string_view_type> { return Splitter::Tail(buf, sz); }
+
+  static auto ReadFromFD(int fd, void* buf, size_t sz) -> ssize_t {
+    if constexpr (internal::DirectBuffer<Buffer>) {
+      // Only the last read of an O_DIRECT file comes up short of a block, leaving the data end
+      // unaligned: there is nothing more to read. Other descriptors may return short reads anywhere.
+      if (reinterpret_cast<uintptr_t>(buf) % Buffer::kDirectIOAlignment != 0) [[unlikely]] {
+        if (auto flags = raw_fcntl(fd, F_GETFL, 0); flags >= 0 && (flags & O_DIRECT)) return 0;
+      }
+    }
+    return raw_read(fd, buf, sz);
+  }
 
   friend class FileReader::BaseReader;
 };
 
+/**
+ * @brief A FileReader that reads with pread(2) from its own offset instead of the file position.
+ *
+ * Several readers can share one descriptor and jump around it independently, e.g. to serve
+ * random lines of a large dump located through a LineIndex.
+ *
+ * @code
+ * auto index = LineIndex::Build("/data/local/tmp/smaps.txt");
+ * auto reader = PreadFileReader<>{"/data/local/tmp/smaps.txt"};
+ * reader.SeekToLine(*index, 100000);
+ * auto line = reader.NextLine();
+ * @endcode
+ */
+template <internal::BufferPolicy Buffer = DefaultBuffer, internal::FixedString kDelimiter = UTF8::LF,
+          internal::StatsPolicy Stats = NoStats>
+  requires(Buffer::size % sizeof(typename decltype(kDelimiter)::value_type) == 0)
+class PreadFileReader : public internal::BaseReader<PreadFileReader<Buffer, kDelimiter, Stats>,
+                                                    std::basic_string_view<typename decltype(kDelimiter)::value_type>,
+                                                    Buffer,
+                                                    Stats> {
+ public:
+  using char_type = decltype(kDelimiter)::value_type;
+  using string_view_type = std::basic_string_view<char_type>;
+
+  explicit PreadFileReader(int fd, uint64_t offset = 0) : PreadFileReader::BaseReader{fd, false}, offset_{offset} {}
+
+  explicit PreadFileReader(const char* pathname)
+      : PreadFileReader::BaseReader{raw_open(pathname, O_RDONLY | O_CLOEXEC), true} {}
+
+  PreadFileReader(int dirfd, const char* pathname)
+      : PreadFileReader::BaseReader{raw_openat(dirfd, pathname, O_RDONLY | O_CLOEXEC), true} {}
+
+  auto operator++() { return NextLine(); }
+
+  auto NextLine() -> std::optional<string_view_type> {
+    return this->NextImpl([] [[gnu::always_inline]] (const uint8_t* buf, size_t available, size_t& scanned) {
+      return Splitter::Split(buf, available, scanned);
+    });
+  }
+
+  auto NextLines(std::span<string_view_type> out) -> size_t {
+    return this->NextBatchImpl(out, [] [[gnu::always_inline]] (const uint8_t* buf, size_t available, size_t& scanned) {
+      return Splitter::Split(buf, available, scanned);
+    });
+  }
+
+  // Continues reading at byte `offset`; previously returned views are invalidated.
+  void Seek(uint64_t offset) {
+    offset_ = offset;
+    this->ResetBuffer();
+  }
+
+  // Continues reading at line `line` (0-based) of a LineIndex built for this file.
+  auto SeekToLine(const auto& index, size_t line) -> bool {
+    auto offset = index.Offset(line);
+    if (!offset) [[unlikely]] {
+      return false;
+    }
+    Seek(*offset);
+    return true;
+  }
+
+ private:
+  using Splitter = internal::LineSplitter<kDelimiter>;
+
+  static auto OnBufferFull(const uint8_t* buf, size_t sz) -> std::optional<string_view_type> {
+    return string_view_type{reinterpret_cast<const char_type*>(buf),
+                            reinterpret_cast<const char_type*>(buf + internal::AlignDown<char_type>(sz))};
+  }
+
+  static auto OnEOF(const uint8_t* buf, size_t sz) -> std::optional<string_view_type> { return Splitter::Tail(buf, sz); }
+
+  auto ReadFromFD(int fd, void* buf, size_t sz) -> ssize_t {
+    auto n = raw_pread64(fd, buf, sz, static_cast<loff_t>(offset_));
+    if (n > 0) [[likely]] {
+      offset_ += static_cast<uint64_t>(n);
+    }
+    return n;
+  }
+
+  uint64_t offset_{};
+
+  friend class PreadFileReader::BaseReader;
+};
+
+/**
+ * @brief A FileReader variant that serves lines straight out of the page cache.
+ *
+ * Regular files are mapped read-only with MADV_SEQUENTIAL and split in place, so no byte is
+ * copied and no read(2) is issued per buffer. Anything that cannot be mapped (procfs, pipes,
+ * sockets, empty files) transparently falls back to a buffered FileReader using `Buffer`.
+ *
+ * @code
+ * for (auto line : MappedFileReader<>{"/apex/com.android.art/lib64/libart.so"}) {}
+ * @endcode
+ *
+ * @note Reading starts at the current file offset of `fd`, which is left untouched.
+ * @warning In mapped mode the views point to read-only memory and stay valid until the reader
+ * is destroyed; in buffered mode the FileReader rules apply. Never write through the views.
+ */
+template <internal::BufferPolicy Buffer = DefaultBuffer, internal::FixedString kDelimiter = UTF8::LF>
+  requires(Buffer::size % sizeof(typename decltype(kDelimiter)::value_type) == 0)
+class MappedFileReader {
+ public:
+  using char_type = decltype(kDelimiter)::value_type;
+  using string_view_type = std::basic_string_view<char_type>;
+  using value_type = string_view_type;
+  using iterator = internal::Iterator<MappedFileReader>;
+
+  explicit MappedFileReader(int fd) : MappedFileReader{fd, false} {}
+
+  explicit MappedFileReader(const char* pathname) : MappedFileReader{raw_open(pathname, O_RDONLY | O_CLOEXEC), true} {}
+
+  MappedFileReader(int dirfd, const char* pathname)
+      : MappedFileReader{raw_openat(dirfd, pathname, O_RDONLY | O_CLOEXEC), true} {}
+
+  MappedFileReader(MappedFileReader&& other) noexcept
+      : fd_{std::exchange(other.fd_, -1)},
+        owned_{std::exchange(other.owned_, false)},
+        map_{std::exchange(other.map_, nullptr)},
+        map_size_{std::exchange(other.map_size_, 0)},
+        map_pos_{std::exchange(other.map_pos_, 0)},
+        fallback_{std::move(other.fallback_)} {}
+
+  auto operator=(MappedFileReader&& other) noexcept -> auto& {
+    if (this != &other) {
+      Release();
+      fd_ = std::exchange(other.fd_, -1);
+      owned_ = std::exchange(other.owned_, false);
+      map_ = std::exchange(other.map_, nullptr);
+      map_size_ = std::exchange(other.map_size_, 0);
+      map_pos_ = std::exchange(other.map_pos_, 0);
+      fallback_ = std::move(other.fallback_);
+    }
+    return *this;
+  }
+
+  MappedFileReader(const MappedFileReader&) = delete;
+  void operator=(const MappedFileReader&) = delete;
+
+  ~MappedFileReader() { Release(); }
+
+  operator bool() const noexcept { return IsValid(); }
+
+  auto operator++() { return NextLine(); }
+  auto operator++(int) { return NextLine(); }
+
+  [[nodiscard]] auto IsValid() const noexcept { return fd_ >= 0; }
+  [[nodiscard]] auto IsMapped() const noexcept { return map_ != nullptr; }
+  [[nodiscard]] auto GetFd() const noexcept { return fd_; }
+
+  [[nodiscard]] auto begin() { return iterator{this}; }
+  [[nodiscard]] auto end() { return iterator{}; }
+
+  auto NextLine() -> std::optional<string_view_type> {
+    if (!map_) [[unlikely]] {
+      if (fallback_) return fallback_->NextLine();
+      return {};
+    }
+
+    auto buf = map_ + map_pos_;
+    auto available = map_size_ - map_pos_;
+    if (auto res = Splitter::Split(buf, available)) [[likely]] {
+      map_pos_ += res->second;
+      return res->first;
+    }
+    map_pos_ = map_size_;
+    return Splitter::Tail(buf, available);
+  }
+
+ private:
+  using Splitter = internal::LineSplitter<kDelimiter>;
+
+  MappedFileReader(int fd, bool owned) : fd_{fd}, owned_{owned} {
+    if (fd_ < 0) [[unlikely]] {
+      return;
+    }
+
+    auto offset = raw_lseek(fd_, 0, SEEK_CUR);
+    if (offset < 0) [[unlikely]] {
+      // ESPIPE: pipes and sockets have no offset and cannot be mapped.
+      fallback_.emplace(fd_);
+      return;
+    }
+
+    // procfs and other pseudo files report no size (or refuse SEEK_END) and are read through the buffer.
+    auto size = raw_lseek(fd_, 0, SEEK_END);
+    raw_lseek(fd_, offset, SEEK_SET);
+    if (size > offset) [[likely]] {
+      auto map = raw_mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_PRIVATE, fd_, 0);
+      if (reinterpret_cast<uintptr_t>(map) < -4095UL) [[likely]] {
+        raw_madvise(map, static_cast<size_t>(size), MADV_SEQUENTIAL);
+        map_ = static_cast<const uint8_t*>(map);
+        map_size_ = static_cast<size_t>(size);
+        map_pos_ = static_cast<size_t>(offset);
+        return;
+      }
+    }
+    fallback_.emplace(fd_);
+  }
+
+  void Release() {
+    if (map_) raw_munmap(const_cast<uint8_t*>(map_), map_size_);
+    fallback_.reset();
+    if (fd_ >= 0 && owned_) raw_close(fd_);
+  }
+
+  int fd_;
+  bool owned_;
+  const uint8_t* map_{};
+  size_t map_size_{};
+  size_t map_pos_{};
+  std::optional<FileReader<Buffer, kDelimiter>> fallback_;
+};
+
 enum class DirEntryType : uint8_t {
   kUnknown = DT_UNKNOWN,
   kFIFO = DT_FIFO,
@@ -553,9 +1678,9 @@ struct DirEntry {
   [[nodiscard]] auto is_socket() const { return type() == DirEntryType::kSocket; }
 };
 
-template <internal::BufferPolicy Buffer = DefaultBuffer>
+template <internal::BufferPolicy Buffer = DefaultBuffer, internal::StatsPolicy Stats = NoStats>
   requires(Buffer::size > offsetof(kernel_dirent64, d_name) && Buffer::size % sizeof(uint64_t) == 0)
-class DirReader : public internal::BaseReader<DirReader<Buffer>, DirEntry, Buffer> {
+class DirReader : public internal::BaseReader<DirReader<Buffer, Stats>, DirEntry, Buffer, Stats> {
  public:
   explicit DirReader(int fd) : DirReader::BaseReader{fd, false} {}
 
@@ -566,23 +1691,31 @@ class DirReader : public internal::BaseReader<DirReader<Buffer>, DirEntry, Buffe
 
   auto operator++() { return NextEntry(); }
 
-  auto NextEntry() -> std::optional<DirEntry> {
-    return this->NextImpl(
-        [] [[gnu::always_inline]] (uint8_t* buf, size_t available) -> std::optional<std::pair<DirEntry, size_t>> {
-          if (available < offsetof(kernel_dirent64, d_name)) [[unlikely]] {
-            return {};
-          }
+  auto NextEntry() -> std::optional<DirEntry> { return this->NextImpl(ParseEntry); }
 
-          auto dir = reinterpret_cast<kernel_dirent64*>(buf);
-          if (available < dir->d_reclen) [[unlikely]] {
-            return {};
-          }
+  /**
+   * Reads up to `out.size()` entries at once: the next entry, plus every entry already returned
+   * by the same getdents64 call. Returns the number of entries written, 0 at the end.
+   *
+   * @warning The entries are invalidated by the next NextEntry/NextEntries call.
+   */
+  auto NextEntries(std::span<DirEntry> out) -> size_t { return this->NextBatchImpl(out, ParseEntry); }
 
-          return std::pair{DirEntry{dir}, dir->d_reclen};
-        });
+ private:
+  [[gnu::always_inline]] static auto ParseEntry(uint8_t* buf, size_t available)
+      -> std::optional<std::pair<DirEntry, size_t>> {
+    if (available < offsetof(kernel_dirent64, d_name)) [[unlikely]] {
+      return {};
+    }
+
+    auto dir = reinterpret_cast<kernel_dirent64*>(buf);
+    if (available < dir->d_reclen) [[unlikely]] {
+      return {};
+    }
+
+    return std::pair{DirEntry{dir}, dir->d_reclen};
   }
 
- private:
   static auto OnBufferFull(const uint8_t*, size_t) -> std::optional<DirEntry> { return {}; }
 
   static auto OnEOF(const uint8_t*, size_t) -> std::optional<DirEntry> { return {}; }
@@ -593,4 +1726,90 @@ class DirReader : public internal::BaseReader<DirReader<Buffer>, DirEntry, Buffe
 
   friend class DirReader::BaseReader;
 };
+
+/**
+ * @brief Reads a file of fixed-size binary records, such as /proc/self/pagemap or /proc/kpageflags,
+ * in batches.
+ *
+ * Every call returns the whole records of one buffer fill as a `std::span<const T>`, so a large
+ * range costs one pread(2) per buffer rather than one per record. Reads go through pread at the
+ * reader's own offset, and SeekToRecords limits them to a range, e.g. the pagemap entries of one
+ * VMA. A partial record at the end of the input is dropped.
+ *
+ * @code
+ * // Present pages of every executable mapping.
+ * auto pagemap = BinaryRecordReader<uint64_t>{"/proc/self/pagemap"};
+ * auto page_size = static_cast<uintptr_t>(getpagesize());
+ * for (auto vma : proc::MapsParser{proc::kVmaRead | proc::kVmaExec}) {
+ *   pagemap.SeekToRecords(vma.vma_start / page_size, (vma.vma_end - vma.vma_start) / page_size);
+ *   size_t present = 0;
+ *   for (auto entries : pagemap) {
+ *     for (auto entry : entries) present += entry >> 63;
+ *   }
+ * }
+ * @endcode
+ *
+ * @warning The span points to the internal buffer and is invalidated by the next call.
+ */
+template <class T, internal::BufferPolicy Buffer = DefaultBuffer, internal::StatsPolicy Stats = NoStats>
+  requires(std::is_trivially_copyable_v<T> && alignof(T) <= alignof(uint64_t) && Buffer::size % sizeof(T) == 0 &&
+           !internal::DirectBuffer<Buffer>)
+class BinaryRecordReader
+    : public internal::BaseReader<BinaryRecordReader<T, Buffer, Stats>, std::span<const T>, Buffer, Stats> {
+ public:
+  explicit BinaryRecordReader(int fd, uint64_t offset = 0)
+      : BinaryRecordReader::BaseReader{fd, false}, offset_{offset} {}
+
+  explicit BinaryRecordReader(const char* pathname)
+      : BinaryRecordReader::BaseReader{raw_open(pathname, O_RDONLY | O_CLOEXEC), true} {}
+
+  BinaryRecordReader(int dirfd, const char* pathname)
+      : BinaryRecordReader::BaseReader{raw_openat(dirfd, pathname, O_RDONLY | O_CLOEXEC), true} {}
+
+  auto operator++() { return NextRecords(); }
+
+  // Returns the records of the next buffer fill, or nothing at the end of the file or range.
+  auto NextRecords() -> std::optional<std::span<const T>> { return this->NextImpl(ParseRecords); }
+
+  // Continues reading at byte `offset`, up to byte `end`; previously returned spans are invalidated.
+  void Seek(uint64_t offset, uint64_t end = UINT64_MAX) {
+    offset_ = offset;
+    end_ = end;
+    this->ResetBuffer();
+  }
+
+  // Reads records [first, first + count) next, as if the file held nothing else.
+  void SeekToRecords(uint64_t first, uint64_t count) { Seek(first * sizeof(T), (first + count) * sizeof(T)); }
+
+ private:
+  [[gnu::always_inline]] static auto ParseRecords(uint8_t* buf, size_t available)
+      -> std::optional<std::pair<std::span<const T>, size_t>> {
+    auto count = available / sizeof(T);
+    if (count == 0) [[unlikely]] {
+      return {};
+    }
+    return std::pair{std::span{reinterpret_cast<const T*>(buf), count}, count * sizeof(T)};
+  }
+
+  static auto OnBufferFull(const uint8_t*, size_t) -> std::optional<std::span<const T>> { return {}; }
+
+  static auto OnEOF(const uint8_t*, size_t) -> std::optional<std::span<const T>> { return {}; }
+
+  auto ReadFromFD(int fd, void* buf, size_t sz) -> ssize_t {
+    if (offset_ >= end_) [[unlikely]] {
+      return 0;
+    }
+    sz = static_cast<size_t>(std::min<uint64_t>(sz, end_ - offset_));
+    auto n = raw_pread64(fd, buf, sz, static_cast<loff_t>(offset_));
+    if (n > 0) [[likely]] {
+      offset_ += static_cast<uint64_t>(n);
+    }
+    return n;
+  }
+
+  uint64_t offset_{};
+  uint64_t end_{UINT64_MAX};
+
+  friend class BinaryRecordReader::BaseReader;
+};
 }  // namespace io
\ No newline at end of file
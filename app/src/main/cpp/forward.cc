@@ -0,0 +1,209 @@
+#include "forward.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <cerrno>
+
+// Declared like the wrappers of linux_syscall_support.h, so they return -errno the same way.
+LSS_INLINE _syscall6(ssize_t, copy_file_range, int, fd_in, loff_t*, off_in, int, fd_out, loff_t*, off_out, size_t,
+                     len, unsigned int, flags)
+LSS_INLINE _syscall4(ssize_t, sendfile, int, out_fd, int, in_fd, off_t*, offset, size_t, count)
+LSS_INLINE _syscall6(ssize_t, splice, int, fd_in, loff_t*, off_in, int, fd_out, loff_t*, off_out, size_t, len,
+                     unsigned int, flags)
+
+namespace io {
+namespace {
+// Bytes asked for per call; the kernel moves less for pipes and procfs.
+constexpr size_t kChunkSize = 1024 * 1024;
+
+auto CopyFileRange(int src, int dst) -> ssize_t {
+  return raw_copy_file_range(src, nullptr, dst, nullptr, kChunkSize, 0);
+}
+
+auto SendFile(int src, int dst) -> ssize_t { return raw_sendfile(dst, src, nullptr, kChunkSize); }
+
+auto Splice(int src, int dst, size_t size) -> ssize_t {
+  return raw_splice(src, nullptr, dst, nullptr, size, SPLICE_F_MOVE);
+}
+
+// Errors with which a method turns down a pair of descriptors before moving anything.
+auto IsRefused(ssize_t error) {
+  return error == -EINVAL || error == -EXDEV || error == -ENOSYS || error == -EOPNOTSUPP || error == -ESPIPE;
+}
+
+auto FileType(int fd) -> unsigned {
+  kernel_stat st;
+  return raw_fstat(fd, &st) == 0 ? st.st_mode & S_IFMT : 0;
+}
+
+// copy_file_range between filesystems returns 0 for procfs and sysfs files on Linux 5.3 to 5.18,
+// as if they were empty, so it is only used when the size says there is something to copy.
+auto HasContent(int fd) {
+  kernel_stat st;
+  return raw_fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0;
+}
+
+// copy_file_range fails with EBADF for an O_APPEND output, the usual way to open a log file.
+auto IsAppending(int fd) {
+  auto flags = raw_fcntl(fd, F_GETFL, 0);
+  return flags >= 0 && (flags & O_APPEND);
+}
+
+// Calls `transfer` until the end of the input. Returns 0 at the end, or the error that stopped it.
+auto Pump(auto&& transfer, ssize_t& total) -> ssize_t {
+  for (;;) {
+    auto n = transfer();
+    if (n > 0) [[likely]] {
+      total += n;
+    } else if (n != -EINTR) {
+      return n;
+    }
+  }
+}
+
+auto WriteFully(int fd, const uint8_t* data, size_t size) -> ssize_t {
+  while (size > 0) {
+    auto n = raw_write(fd, data, size);
+    if (n == -EINTR) continue;
+    if (n < 0) [[unlikely]] {
+      return n;
+    }
+    data += n;
+    size -= static_cast<size_t>(n);
+  }
+  return 0;
+}
+
+// Reads up to `limit` bytes from `src` and writes them to `dst`, until the end or the limit.
+auto Copy(int src, int dst, ssize_t& total, size_t limit = SIZE_MAX) -> ssize_t {
+  std::array<uint8_t, 16 * 1024> buffer;
+  while (limit > 0) {
+    auto n = raw_read(src, buffer.data(), std::min(buffer.size(), limit));
+    if (n == -EINTR) continue;
+    if (n <= 0) return n;
+    if (auto r = WriteFully(dst, buffer.data(), static_cast<size_t>(n)); r < 0) [[unlikely]] {
+      return r;
+    }
+    total += n;
+    limit -= static_cast<size_t>(n);
+  }
+  return 0;
+}
+
+// Splices `src` into a private pipe and the pipe into `dst`. Returns 1 if the input cannot be
+// spliced, so that nothing has been moved.
+auto SpliceThroughPipe(int src, int dst, ssize_t& total) -> ssize_t {
+  int pipe[2];
+  if (auto r = raw_pipe2(pipe, O_CLOEXEC); r < 0) [[unlikely]] {
+    return r;
+  }
+  // A larger pipe means fewer round trips; the default of 64 KiB still works.
+  raw_fcntl(pipe[1], F_SETPIPE_SZ, static_cast<long>(kChunkSize));
+
+  ssize_t r;
+  auto moved = false;
+  auto can_splice_out = true;
+  for (;;) {
+    auto n = Splice(src, pipe[1], kChunkSize);
+    if (n == -EINTR) continue;
+    if (n <= 0) {
+      r = !moved && IsRefused(n) ? 1 : n;
+      break;
+    }
+    moved = true;
+
+    // Data that is in the pipe has been consumed from `src`, so it must reach `dst` one way or another.
+    while (n > 0 && can_splice_out) {
+      auto m = Splice(pipe[0], dst, static_cast<size_t>(n));
+      if (m == -EINTR) continue;
+      if (m < 0) {
+        if (!IsRefused(m)) [[unlikely]] {
+          raw_close(pipe[0]);
+          raw_close(pipe[1]);
+          return m;
+        }
+        can_splice_out = false;
+        break;
+      }
+      total += m;
+      n -= m;
+    }
+    if (!can_splice_out) {
+      if (r = Copy(pipe[0], dst, total, static_cast<size_t>(n)); r < 0) [[unlikely]] {
+        break;
+      }
+      // `dst` takes no splice: the rest goes through user space.
+      r = Copy(src, dst, total);
+      break;
+    }
+  }
+  raw_close(pipe[0]);
+  raw_close(pipe[1]);
+  return r;
+}
+}  // namespace
+
+namespace internal {
+auto WriteVectorFully(int fd, std::span<iovec> iov) -> ssize_t {
+  while (!iov.empty()) {
+    // kernel_iovec has the layout of iovec.
+    auto n = raw_writev(fd, reinterpret_cast<const kernel_iovec*>(iov.data()), iov.size());
+    if (n == -EINTR) continue;
+    if (n < 0) [[unlikely]] {
+      return n;
+    }
+    // Skip what was written, which may end in the middle of a span.
+    auto written = static_cast<size_t>(n);
+    while (!iov.empty() && written >= iov.front().iov_len) {
+      written -= iov.front().iov_len;
+      iov = iov.subspan(1);
+    }
+    if (written > 0) {
+      iov.front().iov_base = static_cast<uint8_t*>(iov.front().iov_base) + written;
+      iov.front().iov_len -= written;
+    }
+  }
+  return 0;
+}
+}  // namespace internal
+
+auto Forward(int src, int dst) -> ssize_t {
+  ssize_t total = 0;
+
+  if (HasContent(src) && FileType(dst) == S_IFREG && !IsAppending(dst)) {
+    if (auto r = Pump([&] { return CopyFileRange(src, dst); }, total); total > 0 || !IsRefused(r)) {
+      return r < 0 ? r : total;
+    }
+  }
+
+  // splice needs a pipe on one end; sendfile takes any output but may refuse pipes on older kernels.
+  if (FileType(src) == S_IFIFO || FileType(dst) == S_IFIFO) {
+    if (auto r = Pump([&] { return Splice(src, dst, kChunkSize); }, total); total > 0 || !IsRefused(r)) {
+      return r < 0 ? r : total;
+    }
+  }
+
+  if (auto r = Pump([&] { return SendFile(src, dst); }, total); total > 0 || !IsRefused(r)) {
+    return r < 0 ? r : total;
+  }
+
+  if (auto r = SpliceThroughPipe(src, dst, total); r != 1) {
+    return r < 0 ? r : total;
+  }
+
+  auto r = Copy(src, dst, total);
+  return r < 0 ? r : total;
+}
+
+auto Forward(const char* pathname, int dst) -> ssize_t {
+  auto src = raw_open(pathname, O_RDONLY | O_CLOEXEC);
+  if (src < 0) [[unlikely]] {
+    return src;
+  }
+  auto r = Forward(src, dst);
+  raw_close(src);
+  return r;
+}
+}  // namespace io
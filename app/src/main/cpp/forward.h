@@ -0,0 +1,148 @@
+#pragma once
+
+#include <sys/uio.h>
+
+#include <array>
+#include <cstring>
+#include <span>
+#include <utility>
+
+#include "file_reader.h"
+
+namespace io {
+namespace internal {
+// Writes every byte of `iov` to `fd`, resuming after short writes. Returns 0 or -errno.
+auto WriteVectorFully(int fd, std::span<iovec> iov) -> ssize_t;
+}  // namespace internal
+
+/**
+ * @brief Copies everything readable from `src` to `dst` without passing it through user space.
+ *
+ * The first method the two descriptors accept is used: copy_file_range between regular files,
+ * splice when one end is a pipe, sendfile, then splice through a private pipe. When the kernel
+ * refuses all of them, e.g. for procfs files without splice support on older kernels, the data
+ * is copied with read and write.
+ *
+ * @code
+ * // Dump the memory map into a log file or a socket.
+ * Forward("/proc/self/maps", log_fd);
+ * @endcode
+ *
+ * @return The number of bytes forwarded, or -errno if an error stopped the copy; some bytes may
+ * have been written by then.
+ */
+auto Forward(int src, int dst) -> ssize_t;
+
+auto Forward(const char* pathname, int dst) -> ssize_t;
+
+/**
+ * @brief Forwards only the records of `src` for which `filter(record)` returns true.
+ *
+ * The records are split exactly as FileReader splits them and passed to the filter without their
+ * delimiter; the matching ones are written out with it, byte for byte. The filter has to see the
+ * data, so this copies it into user space once; consecutive matches are then written in one span
+ * and all spans of a buffer fill in one writev, with nothing formatted again.
+ *
+ * @code
+ * // Only the executable mappings.
+ * Forward("/proc/self/maps", log_fd, [](std::string_view line) { return line.find(" r-xp ") != line.npos; });
+ * @endcode
+ */
+template <internal::FixedString kDelimiter = UTF8::LF, internal::BufferPolicy Buffer = DefaultBuffer>
+auto Forward(int src, int dst, auto&& filter) -> ssize_t {
+  using Splitter = internal::LineSplitter<kDelimiter>;
+  static constexpr size_t kBufferSize = Buffer::size;
+  static constexpr size_t kMaxSpans = 64;
+
+  auto buffer = Buffer::template make_buffer<kBufferSize>();
+  std::array<iovec, kMaxSpans> spans;
+  size_t span_count = 0;
+  ssize_t total = 0;
+
+  auto flush = [&] -> ssize_t {
+    if (span_count == 0) return 0;
+    auto r = internal::WriteVectorFully(dst, std::span{spans}.first(span_count));
+    span_count = 0;
+    return r;
+  };
+  // Adds [pos, pos + size) of the buffer if `record` matches, merged with the previous span if adjacent.
+  auto take = [&](auto record, size_t pos, size_t size) -> ssize_t {
+    if (!filter(record)) return 0;
+    total += static_cast<ssize_t>(size);
+    auto base = &buffer[pos];
+    if (span_count > 0) {
+      auto& last = spans[span_count - 1];
+      if (static_cast<uint8_t*>(last.iov_base) + last.iov_len == base) {
+        last.iov_len += size;
+        return 0;
+      }
+    }
+    if (span_count == kMaxSpans) {
+      if (auto r = flush(); r < 0) [[unlikely]] {
+        return r;
+      }
+    }
+    spans[span_count++] = {.iov_base = base, .iov_len = size};
+    return 0;
+  };
+
+  size_t end = 0;
+  for (;;) {
+    auto n = raw_read(src, &buffer[end], kBufferSize - end);
+    if (n == -EINTR) continue;
+    if (n < 0) [[unlikely]] {
+      return n;
+    }
+    end += static_cast<size_t>(n);
+
+    size_t pos = 0;
+    while (auto res = Splitter::Split(&buffer[pos], end - pos)) {
+      if (auto r = take(res->first, pos, res->second); r < 0) [[unlikely]] {
+        return r;
+      }
+      pos += res->second;
+    }
+
+    if (n == 0) {
+      // The last record needs no delimiter.
+      if (auto tail = Splitter::Tail(&buffer[pos], end - pos)) {
+        if (auto r = take(*tail, pos, end - pos); r < 0) [[unlikely]] {
+          return r;
+        }
+      }
+      auto r = flush();
+      return r < 0 ? r : total;
+    }
+
+    // A record that fills the whole buffer is passed on in pieces, as FileReader does.
+    if (pos == 0 && end == kBufferSize) [[unlikely]] {
+      using char_type = Splitter::char_type;
+      auto size = internal::AlignDown<char_type>(end);
+      auto piece = typename Splitter::string_view_type{reinterpret_cast<const char_type*>(&buffer[0]),
+                                                       size / sizeof(char_type)};
+      if (auto r = take(piece, 0, size); r < 0) [[unlikely]] {
+        return r;
+      }
+      pos = size;
+    }
+
+    // Spans point into the buffer, so they go out before the partial record is moved down.
+    if (auto r = flush(); r < 0) [[unlikely]] {
+      return r;
+    }
+    memmove(&buffer[0], &buffer[pos], end - pos);
+    end -= pos;
+  }
+}
+
+template <internal::FixedString kDelimiter = UTF8::LF, internal::BufferPolicy Buffer = DefaultBuffer>
+auto Forward(const char* pathname, int dst, auto&& filter) -> ssize_t {
+  auto src = raw_open(pathname, O_RDONLY | O_CLOEXEC);
+  if (src < 0) [[unlikely]] {
+    return src;
+  }
+  auto r = Forward<kDelimiter, Buffer>(src, dst, filter);
+  raw_close(src);
+  return r;
+}
+}  // namespace io
@@ -0,0 +1,358 @@
+#pragma once
+
+#include <array>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <optional>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+namespace io {
+/**
+ * @brief A bump allocator for coroutine frames.
+ *
+ * While a CoroutineArena::Scope is active on a thread, every io::Generator created on that thread
+ * takes its frame from the arena instead of the heap, which turns a pipeline of stages into a few
+ * pointer bumps. Frames are returned in any order, and the space is reclaimed once all of them are
+ * gone. When the arena is full, frames silently come from the heap.
+ *
+ * @code
+ * // A MapsParser frame carries the parser's 4 KiB name buffer; with the filter both take about 4.6 KiB.
+ * alignas(std::max_align_t) std::array<std::byte, 8192> storage;
+ * auto arena = CoroutineArena{storage};
+ * auto scope = CoroutineArena::Scope{arena};
+ * for (auto& vma : Generate(MapsParser{}) | Filter([](auto& vma) { return vma.vma_flags & kVmaExec; })) {}
+ * @endcode
+ *
+ * @warning The arena must outlive every generator allocated from it.
+ */
+class CoroutineArena {
+ public:
+  explicit CoroutineArena(std::span<std::byte> storage) : storage_{storage} {}
+
+  CoroutineArena(const CoroutineArena&) = delete;
+  void operator=(const CoroutineArena&) = delete;
+
+  // Makes an arena the one used for coroutine frames on this thread, restoring the previous one on exit.
+  class Scope {
+   public:
+    explicit Scope(CoroutineArena& arena) : previous_{std::exchange(current_, &arena)} {}
+
+    Scope(const Scope&) = delete;
+    void operator=(const Scope&) = delete;
+
+    ~Scope() { current_ = previous_; }
+
+   private:
+    CoroutineArena* previous_;
+  };
+
+  [[nodiscard]] static auto Current() noexcept { return current_; }
+
+  auto Allocate(size_t size) noexcept -> void* {
+    size = (size + kAlignment - 1) & ~(kAlignment - 1);
+    if (storage_.size() - used_ < size) [[unlikely]] {
+      return nullptr;
+    }
+    auto p = storage_.data() + used_;
+    used_ += size;
+    ++live_;
+    return p;
+  }
+
+  void Deallocate(void*) noexcept {
+    if (--live_ == 0) used_ = 0;
+  }
+
+  [[nodiscard]] auto used() const noexcept { return used_; }
+
+ private:
+  static constexpr size_t kAlignment = alignof(std::max_align_t);
+
+  static inline thread_local CoroutineArena* current_{};
+
+  std::span<std::byte> storage_;
+  size_t used_{};
+  size_t live_{};
+};
+
+namespace internal {
+// Every frame is prefixed with the arena it came from (or nullptr for the heap), so that it can
+// be given back to the right place no matter which thread destroys it.
+struct alignas(std::max_align_t) FrameHeader {
+  CoroutineArena* arena;
+};
+
+inline auto AllocateFrame(size_t size) -> void* {
+  auto total = sizeof(FrameHeader) + size;
+  auto arena = CoroutineArena::Current();
+  void* p = arena ? arena->Allocate(total) : nullptr;
+  if (!p) [[unlikely]] {
+    arena = nullptr;
+    p = ::operator new(total);
+  }
+  auto header = new (p) FrameHeader{arena};
+  return header + 1;
+}
+
+inline void DeallocateFrame(void* frame) {
+  auto header = reinterpret_cast<FrameHeader*>(static_cast<std::byte*>(frame) - sizeof(FrameHeader));
+  if (header->arena) {
+    header->arena->Deallocate(header);
+  } else {
+    ::operator delete(header);
+  }
+}
+}  // namespace internal
+
+/**
+ * @brief A lazily evaluated sequence produced by a coroutine.
+ *
+ * Values are produced on demand: the coroutine runs until its next `co_yield` whenever the
+ * iterator advances. A Generator is a single-pass range; readers and stages compose with `|`.
+ *
+ * @code
+ * auto Numbers() -> Generator<int> {
+ *   for (int i = 0;; ++i) co_yield i;
+ * }
+ * for (auto n : Numbers() | Filter([](int n) { return n % 2; }) | Take(3)) {}  // 1, 3, 5
+ * @endcode
+ *
+ * @warning What is yielded lives in the coroutine: a reference obtained from the iterator is
+ * valid until the next increment.
+ */
+template <typename T>
+class Generator {
+ public:
+  using value_type = std::remove_cvref_t<T>;
+  using reference = std::conditional_t<std::is_reference_v<T>, T, T&>;
+  using pointer = std::add_pointer_t<reference>;
+
+  struct promise_type {
+    pointer value;
+
+    auto get_return_object() { return Generator{std::coroutine_handle<promise_type>::from_promise(*this)}; }
+
+    static auto initial_suspend() noexcept { return std::suspend_always{}; }
+    static auto final_suspend() noexcept { return std::suspend_always{}; }
+
+    auto yield_value(std::remove_reference_t<reference>& v) noexcept {
+      value = std::addressof(v);
+      return std::suspend_always{};
+    }
+
+    auto yield_value(std::remove_reference_t<reference>&& v) noexcept {
+      value = std::addressof(v);
+      return std::suspend_always{};
+    }
+
+    void return_void() noexcept {}
+
+    // Built without exceptions: nothing can be thrown out of the coroutine body.
+    [[noreturn]] static void unhandled_exception() { abort(); }
+
+    static auto operator new(size_t size) -> void* { return internal::AllocateFrame(size); }
+    static void operator delete(void* frame) { internal::DeallocateFrame(frame); }
+  };
+
+  class iterator {
+   public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = Generator::value_type;
+    using difference_type = std::ptrdiff_t;
+    using reference = Generator::reference;
+    using pointer = Generator::pointer;
+
+    iterator() = default;
+
+    explicit iterator(std::coroutine_handle<promise_type> handle) : handle_{handle} {}
+
+    auto operator*() const noexcept -> reference { return static_cast<reference>(*handle_.promise().value); }
+    auto operator->() const noexcept -> pointer { return handle_.promise().value; }
+
+    auto operator++() -> iterator& {
+      handle_.resume();
+      return *this;
+    }
+    void operator++(int) { operator++(); }
+
+    friend auto operator==(const iterator& it, std::default_sentinel_t) noexcept -> bool {
+      return !it.handle_ || it.handle_.done();
+    }
+
+   private:
+    std::coroutine_handle<promise_type> handle_;
+  };
+
+  Generator() = default;
+
+  Generator(Generator&& other) noexcept : handle_{std::exchange(other.handle_, nullptr)} {}
+
+  auto operator=(Generator&& other) noexcept -> Generator& {
+    if (this != &other) {
+      if (handle_) handle_.destroy();
+      handle_ = std::exchange(other.handle_, nullptr);
+    }
+    return *this;
+  }
+
+  Generator(const Generator&) = delete;
+  void operator=(const Generator&) = delete;
+
+  ~Generator() {
+    if (handle_) handle_.destroy();
+  }
+
+  [[nodiscard]] auto begin() -> iterator {
+    if (handle_) handle_.resume();
+    return iterator{handle_};
+  }
+  [[nodiscard]] auto end() noexcept { return std::default_sentinel; }
+
+  // Resumes the coroutine and returns a copy of the next value, or nothing once it has finished.
+  auto Next() -> std::optional<value_type> {
+    if (!handle_ || handle_.done()) [[unlikely]] {
+      return {};
+    }
+    handle_.resume();
+    if (handle_.done()) return {};
+    return *handle_.promise().value;
+  }
+
+ private:
+  explicit Generator(std::coroutine_handle<promise_type> handle) : handle_{handle} {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+namespace internal {
+template <typename Reader>
+auto GenerateOwned(Reader reader) -> Generator<typename Reader::value_type&> {
+  for (auto& value : reader) co_yield value;
+}
+
+template <typename T, typename Pred>
+auto FilterImpl(Generator<T> source, Pred pred) -> Generator<T> {
+  for (auto&& value : source) {
+    if (std::invoke(pred, std::as_const(value))) co_yield static_cast<T&&>(value);
+  }
+}
+
+template <typename T, typename Func>
+auto TransformImpl(Generator<T> source, Func func)
+    -> Generator<std::invoke_result_t<Func&, typename Generator<T>::reference>> {
+  for (auto&& value : source) co_yield std::invoke(func, static_cast<typename Generator<T>::reference>(value));
+}
+
+template <typename T>
+auto TakeImpl(Generator<T> source, size_t count) -> Generator<T> {
+  if (count == 0) co_return;
+  for (auto&& value : source) {
+    co_yield static_cast<T&&>(value);
+    if (--count == 0) co_return;
+  }
+}
+
+template <size_t N, typename T>
+auto BatchImpl(Generator<T> source) -> Generator<std::span<typename Generator<T>::value_type>> {
+  // The batch lives in the frame, so no container is ever allocated.
+  std::array<typename Generator<T>::value_type, N> batch;
+  size_t size = 0;
+  for (auto&& value : source) {
+    batch[size++] = value;
+    if (size == N) {
+      co_yield std::span{batch};
+      size = 0;
+    }
+  }
+  if (size > 0) co_yield std::span{batch}.first(size);
+}
+
+template <typename Pred>
+struct FilterStage {
+  Pred pred;
+};
+
+template <typename Func>
+struct TransformStage {
+  Func func;
+};
+
+struct TakeStage {
+  size_t count;
+};
+
+template <size_t N>
+struct BatchStage {};
+}  // namespace internal
+
+/**
+ * Wraps any reader of this library (FileReader, DirReader, MapsParser, SMapsParser, ...) in a
+ * Generator. An lvalue reader is borrowed and must outlive the generator; an rvalue reader is
+ * moved into the coroutine frame.
+ */
+template <typename Reader>
+auto Generate(Reader& reader) -> Generator<typename Reader::value_type&> {
+  for (auto& value : reader) co_yield value;
+}
+
+template <typename Reader>
+  requires(!std::is_lvalue_reference_v<Reader>)
+auto Generate(Reader&& reader) -> Generator<typename Reader::value_type&> {
+  return internal::GenerateOwned(std::move(reader));
+}
+
+// Keeps the values for which `pred` returns true.
+template <typename Pred>
+auto Filter(Pred pred) {
+  return internal::FilterStage<Pred>{std::move(pred)};
+}
+
+// Replaces every value with `func(value)`.
+template <typename Func>
+auto Transform(Func func) {
+  return internal::TransformStage<Func>{std::move(func)};
+}
+
+// Stops after `count` values, without producing (or reading) any further one.
+inline auto Take(size_t count) { return internal::TakeStage{count}; }
+
+/**
+ * Groups values into spans of up to N, copied into storage inside the coroutine frame.
+ *
+ * @warning Views such as FileReader lines are only valid until the reader refills its buffer,
+ * so they must not be batched; use FileReader::NextLines, or Transform them into owning values.
+ */
+template <size_t N>
+  requires(N > 0)
+auto Batch() {
+  return internal::BatchStage<N>{};
+}
+
+template <typename T, typename Pred>
+auto operator|(Generator<T>&& source, internal::FilterStage<Pred> stage) {
+  return internal::FilterImpl(std::move(source), std::move(stage.pred));
+}
+
+template <typename T, typename Func>
+auto operator|(Generator<T>&& source, internal::TransformStage<Func> stage) {
+  return internal::TransformImpl(std::move(source), std::move(stage.func));
+}
+
+template <typename T>
+auto operator|(Generator<T>&& source, internal::TakeStage stage) {
+  return internal::TakeImpl(std::move(source), stage.count);
+}
+
+template <typename T, size_t N>
+auto operator|(Generator<T>&& source, internal::BatchStage<N>) {
+  return internal::BatchImpl<N>(std::move(source));
+}
+}  // namespace io
@@ -0,0 +1,309 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "decimal_parser.h"
+#include "file_reader.h"
+
+namespace io::proc {
+/**
+ * Keys known at compile time, mapped to the indices 0..size-1 by a perfect hash: one FNV-1a pass
+ * over a key, one table load and one comparison tell whether it is in the set and where. The seed
+ * that makes the hash collision free is searched for at compile time.
+ */
+template <::io::internal::FixedString... kKeys>
+  requires(sizeof...(kKeys) > 0 && sizeof...(kKeys) < 255 &&
+           (std::is_same_v<typename decltype(kKeys)::value_type, char> && ...))
+struct KeySet {
+  static constexpr size_t size = sizeof...(kKeys);
+
+  static constexpr std::array<std::string_view, size> kNames{std::string_view{kKeys.data_, kKeys.size()}...};
+
+  static constexpr uint32_t Step(uint32_t hash, char c) { return (hash ^ static_cast<uint8_t>(c)) * 16777619u; }
+
+  static constexpr uint32_t Hash(uint32_t hash, std::string_view key) {
+    for (auto c : key) hash = Step(hash, c);
+    return hash;
+  }
+
+ private:
+  static constexpr uint8_t kEmpty = 0xff;
+  // Four slots per key keep the expected number of seeds to try small.
+  static constexpr size_t kTableSize = std::bit_ceil(size * 4);
+  static constexpr int kShift = 32 - std::countr_zero(kTableSize);
+
+  struct Table {
+    uint32_t seed;
+    std::array<uint8_t, kTableSize> slots;
+    bool found;
+  };
+
+  static constexpr auto kTable = [] consteval {
+    auto table = Table{};
+    for (uint32_t seed = 2166136261u, tries = 0; tries < 4096; seed += 0x9e3779b9u, ++tries) {
+      table.seed = seed;
+      table.slots.fill(kEmpty);
+      table.found = true;
+      for (size_t i = 0; i < size && table.found; ++i) {
+        auto& slot = table.slots[Hash(seed, kNames[i]) >> kShift];
+        table.found = slot == kEmpty;
+        slot = static_cast<uint8_t>(i);
+      }
+      if (table.found) break;
+    }
+    return table;
+  }();
+  static_assert(kTable.found, "keys must be unique");
+
+ public:
+  static constexpr uint32_t kSeed = kTable.seed;
+
+  // Index of `key`, whose hash is Hash(kSeed, key), or nothing if it is not in the set.
+  [[gnu::always_inline]] static auto Find(std::string_view key, uint32_t hash) -> std::optional<size_t> {
+    auto slot = kTable.slots[hash >> kShift];
+    if (slot == kEmpty || kNames[slot] != key) return {};
+    return slot;
+  }
+
+  static auto Find(std::string_view key) -> std::optional<size_t> { return Find(key, Hash(kSeed, key)); }
+
+  template <::io::internal::FixedString kKey>
+  static constexpr size_t kIndexOf = [] consteval {
+    size_t i = 0;
+    while (i < size && kNames[i] != std::string_view{kKey.data_, kKey.size()}) ++i;
+    return i;
+  }();
+
+  // The name of `kKey` as stored in the set; naming a key that is not in it does not compile.
+  template <::io::internal::FixedString kKey>
+    requires(kIndexOf<kKey> < size)
+  static constexpr std::string_view kName = kNames[kIndexOf<kKey>];
+};
+
+/**
+ * The fields of a `Key:   value` block, as found in /proc/self/status, /proc/meminfo,
+ * smaps_rollup and each VMA of /proc/self/smaps. Every line is parsed once, when it is added:
+ * values of the keys in `Keys` go to fixed slots, with their leading number already converted
+ * (the 123 of "123 kB"); other keys are kept in order as views.
+ *
+ * @warning Values are views into the added lines and share their lifetime.
+ */
+template <typename Keys>
+class KeyValues {
+ public:
+  // Parses one line. Returns false if it has no ':' and was not stored.
+  auto Add(std::string_view line) -> bool {
+    auto index = Store(line);
+    if (index && *index < Keys::size) [[likely]] {
+      numbers_[*index] = ParseNumber(strings_[*index]);
+    }
+    return index.has_value();
+  }
+
+  // Parses the lines of a whole record, converting the numbers of all known keys in one pass once
+  // every line is placed. Returns the number of lines stored.
+  auto AddAll(std::span<const std::string_view> lines) -> size_t {
+    size_t count = 0;
+    for (auto line : lines) count += Store(line).has_value();
+    ::io::internal::ParseNumbers(strings_, numbers_);
+    return count;
+  }
+
+  void Clear() {
+    strings_ = {};
+    numbers_ = {};
+    unknown_.clear();
+  }
+
+  // Leading number of the value of a key in `Keys`, or nothing if it is absent or not a number.
+  template <::io::internal::FixedString kKey>
+  [[nodiscard]] auto get() const -> std::optional<uint64_t> {
+    static_assert(Keys::template kIndexOf<kKey> < Keys::size, "not a key of the set");
+    return numbers_[Keys::template kIndexOf<kKey>];
+  }
+
+  template <::io::internal::FixedString kKey>
+  [[nodiscard]] auto get_string() const -> std::string_view {
+    static_assert(Keys::template kIndexOf<kKey> < Keys::size, "not a key of the set");
+    return strings_[Keys::template kIndexOf<kKey>];
+  }
+
+  // Same for a key chosen at runtime, which may also be one of the unknown keys.
+  [[nodiscard]] auto get(std::string_view key) const -> std::optional<uint64_t> {
+    if (auto index = Keys::Find(key)) [[likely]] {
+      return numbers_[*index];
+    }
+    return ParseNumber(FindUnknown(key));
+  }
+
+  [[nodiscard]] auto get_string(std::string_view key) const -> std::string_view {
+    if (auto index = Keys::Find(key)) [[likely]] {
+      return strings_[*index];
+    }
+    return FindUnknown(key);
+  }
+
+  // Whether the key was seen, even with an empty value.
+  [[nodiscard]] auto contains(std::string_view key) const -> bool { return get_string(key).data() != nullptr; }
+
+  // Keys that are not in `Keys`, with their values, in input order.
+  [[nodiscard]] auto unknown() const -> std::span<const std::pair<std::string_view, std::string_view>> {
+    return unknown_;
+  }
+
+ private:
+  static auto ParseNumber(std::string_view value) { return ::io::internal::ParseNumber(value); }
+
+  // Splits a line and stores its value. Returns the slot of its key, Keys::size for an unknown key
+  // or nothing if the line has no ':'.
+  auto Store(std::string_view line) -> std::optional<size_t> {
+    auto hash = Keys::kSeed;
+    size_t colon = 0;
+    for (; colon < line.size() && line[colon] != ':'; ++colon) hash = Keys::Step(hash, line[colon]);
+    if (colon == line.size()) [[unlikely]] {
+      return {};
+    }
+
+    auto key = line.substr(0, colon);
+    auto pos = colon + 1;
+    while (pos < line.size() && (line[pos] == ' ' || line[pos] == '\t')) ++pos;
+    auto value = line.substr(pos);
+
+    if (auto index = Keys::Find(key, hash)) [[likely]] {
+      strings_[*index] = value;
+      return *index;
+    }
+    unknown_.emplace_back(key, value);
+    return Keys::size;
+  }
+
+  auto FindUnknown(std::string_view key) const -> std::string_view {
+    for (auto& [name, value] : unknown_) {
+      if (name == key) return value;
+    }
+    return {};
+  }
+
+  std::array<std::string_view, Keys::size> strings_{};
+  std::array<std::optional<uint64_t>, Keys::size> numbers_{};
+  std::vector<std::pair<std::string_view, std::string_view>> unknown_;
+};
+
+/**
+ * @brief Reads a whole `Key:   value` file such as /proc/self/status into KeyValues.
+ *
+ * The file is read into the buffer in one go and parsed in a single pass; Refresh reads it again
+ * through the same descriptor, which suits polling. A file larger than the buffer is cut at the
+ * last whole line that fits and reported by truncated().
+ *
+ * @code
+ * using StatusKeys = KeySet<"State", "VmRSS", "VmHWM", "Threads", "TracerPid">;
+ * auto status = ProcKeyValueReader<StatusKeys>{"/proc/self/status"};
+ * if (status.values().get<"TracerPid">().value_or(0) != 0) {}
+ * auto rss_kb = status.values().get<"VmRSS">();
+ * @endcode
+ */
+template <typename Keys, ::io::internal::BufferPolicy Buffer = DefaultBuffer>
+class ProcKeyValueReader {
+ public:
+  explicit ProcKeyValueReader(const char* pathname) : ProcKeyValueReader{AT_FDCWD, pathname} {}
+
+  ProcKeyValueReader(int dirfd, const char* pathname)
+      : fd_{raw_openat(dirfd, pathname, O_RDONLY | O_CLOEXEC)},
+        buffer_{Buffer::template make_buffer<Buffer::size>()} {
+    Refresh();
+  }
+
+  // Values are views into the buffer, so they are parsed again for the new one.
+  ProcKeyValueReader(ProcKeyValueReader&& other) noexcept
+      : fd_{std::exchange(other.fd_, -1)},
+        buffer_{std::move(other.buffer_)},
+        size_{std::exchange(other.size_, 0)},
+        truncated_{other.truncated_} {
+    Parse();
+  }
+
+  auto operator=(ProcKeyValueReader&& other) noexcept -> auto& {
+    if (this != &other) {
+      if (fd_ >= 0) raw_close(fd_);
+      fd_ = std::exchange(other.fd_, -1);
+      buffer_ = std::move(other.buffer_);
+      size_ = std::exchange(other.size_, 0);
+      truncated_ = other.truncated_;
+      Parse();
+    }
+    return *this;
+  }
+
+  ProcKeyValueReader(const ProcKeyValueReader&) = delete;
+  void operator=(const ProcKeyValueReader&) = delete;
+
+  ~ProcKeyValueReader() {
+    if (fd_ >= 0) [[likely]] {
+      raw_close(fd_);
+    }
+  }
+
+  [[nodiscard]] auto IsValid() const noexcept { return fd_ >= 0; }
+  operator bool() const noexcept { return IsValid(); }
+
+  [[nodiscard]] auto values() const noexcept -> const KeyValues<Keys>& { return values_; }
+  [[nodiscard]] auto truncated() const noexcept { return truncated_; }
+
+  // Reads the file again from the start. Invalidates the views of the previous values.
+  auto Refresh() -> bool {
+    size_ = 0;
+    truncated_ = false;
+    values_.Clear();
+    if (fd_ < 0 || raw_lseek(fd_, 0, SEEK_SET) < 0) [[unlikely]] {
+      return false;
+    }
+
+    while (size_ < Buffer::size) {
+      auto n = raw_read(fd_, &buffer_[size_], Buffer::size - size_);
+      if (n == -EINTR) continue;
+      if (n < 0) [[unlikely]] {
+        return false;
+      }
+      if (n == 0) break;
+      size_ += static_cast<size_t>(n);
+    }
+    if (size_ == Buffer::size) {
+      char probe;
+      truncated_ = raw_read(fd_, &probe, 1) > 0;
+    }
+    Parse();
+    return true;
+  }
+
+ private:
+  using Splitter = ::io::internal::LineSplitter<UTF8::LF>;
+
+  void Parse() {
+    values_.Clear();
+    size_t pos = 0;
+    while (auto res = Splitter::Split(&buffer_[pos], size_ - pos)) {
+      values_.Add(res->first);
+      pos += res->second;
+    }
+    // A cut file ends in part of a line, which is dropped.
+    if (!truncated_) {
+      if (auto tail = Splitter::Tail(&buffer_[pos], size_ - pos)) values_.Add(*tail);
+    }
+  }
+
+  int fd_;
+  Buffer::template type<Buffer::size> buffer_;
+  size_t size_{};
+  bool truncated_{};
+  KeyValues<Keys> values_;
+};
+}  // namespace io::proc
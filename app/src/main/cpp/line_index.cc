@@ -0,0 +1,149 @@
+#include "line_index.h"
+
+#include <fcntl.h>
+
+#include <cerrno>
+
+namespace io {
+namespace {
+constexpr char kMagic[4] = {'L', 'I', 'D', 'X'};
+constexpr uint32_t kVersion = 1;
+
+struct IndexHeader {
+  char magic[4];
+  uint32_t version;
+  uint64_t file_size;
+  uint64_t lines;
+  uint64_t deltas_size;
+};
+
+// LEB128: seven bits per byte, low bits first, the high bit set on every byte but the last.
+void EncodeDelta(std::vector<uint8_t>& out, uint64_t value) {
+  while (value >= 0x80) {
+    out.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<uint8_t>(value));
+}
+
+auto DecodeDelta(const uint8_t* data, size_t size, size_t& pos) -> std::optional<uint64_t> {
+  uint64_t value = 0;
+  for (unsigned shift = 0; pos < size && shift < 64; shift += 7) {
+    auto byte = data[pos++];
+    value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+    if ((byte & 0x80) == 0) [[likely]] {
+      return value;
+    }
+  }
+  return {};
+}
+
+auto ReadFully(int fd, void* buf, size_t size) -> bool {
+  for (auto p = static_cast<uint8_t*>(buf); size > 0;) {
+    auto n = raw_read(fd, p, size);
+    if (n == -EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+
+auto WriteFully(int fd, const void* buf, size_t size) -> bool {
+  for (auto p = static_cast<const uint8_t*>(buf); size > 0;) {
+    auto n = raw_write(fd, p, size);
+    if (n == -EINTR) continue;
+    if (n <= 0) return false;
+    p += n;
+    size -= static_cast<size_t>(n);
+  }
+  return true;
+}
+}  // namespace
+
+void LineIndex::Append(uint64_t offset) {
+  // Every line stores its delta, so the deltas alone can rebuild the checkpoints on Load.
+  EncodeDelta(deltas_, offset - last_offset_);
+  if (size_ % kCheckpointInterval == 0) {
+    checkpoints_.push_back({.offset = offset, .delta_pos = deltas_.size()});
+  }
+  last_offset_ = offset;
+  ++size_;
+}
+
+auto LineIndex::Offset(size_t line) const -> std::optional<uint64_t> {
+  if (line >= size_) [[unlikely]] {
+    return {};
+  }
+  auto& checkpoint = checkpoints_[line / kCheckpointInterval];
+  auto offset = checkpoint.offset;
+  auto pos = checkpoint.delta_pos;
+  for (auto i = line % kCheckpointInterval; i > 0; --i) {
+    offset += *DecodeDelta(deltas_.data(), deltas_.size(), pos);
+  }
+  return offset;
+}
+
+auto LineIndex::Save(const char* pathname) const -> bool {
+  auto fd = raw_open(pathname, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0) [[unlikely]] {
+    return false;
+  }
+  auto header = IndexHeader{
+      .magic = {kMagic[0], kMagic[1], kMagic[2], kMagic[3]},
+      .version = kVersion,
+      .file_size = file_size_,
+      .lines = size_,
+      .deltas_size = deltas_.size(),
+  };
+  auto ok = WriteFully(fd, &header, sizeof(header)) && WriteFully(fd, deltas_.data(), deltas_.size());
+  raw_close(fd);
+  return ok;
+}
+
+auto LineIndex::Load(const char* pathname) -> std::optional<LineIndex> {
+  auto fd = raw_open(pathname, O_RDONLY | O_CLOEXEC);
+  if (fd < 0) [[unlikely]] {
+    return {};
+  }
+
+  kernel_stat st;
+  IndexHeader header;
+  std::vector<uint8_t> deltas;
+  // The header is untrusted: every line takes one to ten LEB128 bytes and the deltas fill the rest of
+  // the file, which bounds both counts before anything is sized or multiplied from them.
+  auto ok = raw_fstat(fd, &st) == 0 && ReadFully(fd, &header, sizeof(header)) &&
+            memcmp(header.magic, kMagic, sizeof(kMagic)) == 0 && header.version == kVersion &&
+            header.deltas_size == static_cast<uint64_t>(st.st_size) - sizeof(header) &&
+            header.lines <= header.deltas_size && header.deltas_size <= header.lines * 10;
+  if (ok) {
+    deltas.resize(header.deltas_size);
+    ok = ReadFully(fd, deltas.data(), deltas.size());
+  }
+  raw_close(fd);
+  if (!ok) [[unlikely]] {
+    return {};
+  }
+
+  auto index = LineIndex{};
+  index.file_size_ = header.file_size;
+  index.checkpoints_.reserve((header.lines + kCheckpointInterval - 1) / kCheckpointInterval);
+  size_t pos = 0;
+  for (size_t line = 0; line < header.lines; ++line) {
+    auto delta = DecodeDelta(deltas.data(), deltas.size(), pos);
+    if (!delta) [[unlikely]] {
+      return {};
+    }
+    index.last_offset_ += *delta;
+    if (line % kCheckpointInterval == 0) {
+      index.checkpoints_.push_back({.offset = index.last_offset_, .delta_pos = pos});
+    }
+  }
+  if (pos != deltas.size() || index.last_offset_ > index.file_size_) [[unlikely]] {
+    return {};
+  }
+  index.size_ = header.lines;
+  index.deltas_ = std::move(deltas);
+  return index;
+}
+}  // namespace io
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <vector>
+
+#include "file_reader.h"
+
+namespace io {
+/**
+ * @brief Byte offsets of every line of a file, for jumping straight to line N.
+ *
+ * The index is built in one pass with the same splitter (and vector kernels) FileReader uses,
+ * reading the file with pread so the file position is left alone. Offsets are kept as
+ * variable-length deltas, typically one or two bytes per line, with an absolute checkpoint every
+ * kCheckpointInterval lines, so a lookup decodes at most that many deltas.
+ *
+ * The encoded deltas can be saved next to the file and loaded back instead of rescanning.
+ * The index records the size of the file it was built for; compare it with the file before
+ * trusting a loaded index.
+ *
+ * @code
+ * auto index = LineIndex::Load("/data/local/tmp/smaps.txt.idx");
+ * if (!index) {
+ *   index = LineIndex::Build("/data/local/tmp/smaps.txt");
+ *   index->Save("/data/local/tmp/smaps.txt.idx");
+ * }
+ * auto reader = FileReader<>{"/data/local/tmp/smaps.txt"};
+ * reader.SeekToLine(*index, 123456);
+ * @endcode
+ */
+class LineIndex {
+ public:
+  static constexpr size_t kCheckpointInterval = 64;
+
+  LineIndex() = default;
+
+  /**
+   * Indexes the lines of `fd` from offset 0 to its end. Lines are cut exactly as FileReader with
+   * the same `kDelimiter` cuts them, except that lines longer than the buffer are not split.
+   * Returns nothing if the file cannot be read.
+   */
+  template <internal::FixedString kDelimiter = UTF8::LF, internal::BufferPolicy Buffer = DefaultHeapBuffer>
+  static auto Build(int fd) -> std::optional<LineIndex>;
+
+  template <internal::FixedString kDelimiter = UTF8::LF, internal::BufferPolicy Buffer = DefaultHeapBuffer>
+  static auto Build(const char* pathname) -> std::optional<LineIndex> {
+    auto fd = raw_open(pathname, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) [[unlikely]] {
+      return {};
+    }
+    auto index = Build<kDelimiter, Buffer>(fd);
+    raw_close(fd);
+    return index;
+  }
+
+  // Reads an index written by Save; returns nothing if it is missing or malformed.
+  static auto Load(const char* pathname) -> std::optional<LineIndex>;
+
+  auto Save(const char* pathname) const -> bool;
+
+  // Number of lines.
+  [[nodiscard]] auto size() const noexcept { return size_; }
+  // Size of the indexed file when the index was built.
+  [[nodiscard]] auto file_size() const noexcept { return file_size_; }
+
+  // Byte offset at which line `line` (0-based) starts.
+  [[nodiscard]] auto Offset(size_t line) const -> std::optional<uint64_t>;
+
+ private:
+  struct Checkpoint {
+    uint64_t offset;
+    // Position in deltas_ of the delta leading to the line after the checkpoint.
+    size_t delta_pos;
+  };
+
+  void Append(uint64_t offset);
+
+  std::vector<uint8_t> deltas_;
+  std::vector<Checkpoint> checkpoints_;
+  uint64_t last_offset_{};
+  uint64_t file_size_{};
+  size_t size_{};
+};
+
+template <internal::FixedString kDelimiter, internal::BufferPolicy Buffer>
+auto LineIndex::Build(int fd) -> std::optional<LineIndex> {
+  using Splitter = internal::LineSplitter<kDelimiter>;
+  using char_type = Splitter::char_type;
+
+  // Bytes kept from the end of one chunk for the next one: a delimiter may straddle the two.
+  static constexpr size_t kCarry = Splitter::kLength * sizeof(char_type) - 1;
+  static constexpr size_t kChunkSize = Buffer::size;
+
+  // Room for the carry plus a code unit cut in half.
+  auto buffer = Buffer::template make_buffer<kChunkSize + kCarry + sizeof(char_type)>();
+  auto index = LineIndex{};
+  // File offsets of the next pread, of buffer[0] and of the line being scanned.
+  uint64_t offset = 0;
+  uint64_t base = 0;
+  uint64_t line_start = 0;
+  size_t carry = 0;
+
+  for (;;) {
+    ssize_t n;
+    do {
+      n = raw_pread64(fd, &buffer[carry], kChunkSize, static_cast<loff_t>(offset));
+    } while (n == -EINTR);
+    if (n < 0) [[unlikely]] {
+      return {};
+    }
+    if (n == 0) break;
+    offset += static_cast<uint64_t>(n);
+
+    auto available = carry + static_cast<size_t>(n);
+    size_t pos = 0;
+    while (auto res = Splitter::Split(&buffer[pos], available - pos)) {
+      index.Append(line_start);
+      pos += res->second;
+      line_start = base + pos;
+    }
+
+    // Only the tail that may hold the start of a delimiter is searched again, cut so that
+    // buffer[0] stays on a code unit boundary of the line.
+    auto rem = available - pos;
+    auto keep = std::min(rem, kCarry);
+    keep += (rem - keep) % sizeof(char_type);
+    memmove(&buffer[0], &buffer[available - keep], keep);
+    base += available - keep;
+    carry = keep;
+  }
+
+  // The last line needs no delimiter, as long as it holds a whole code unit (see LineSplitter::Tail).
+  if (offset - line_start >= sizeof(char_type)) index.Append(line_start);
+  index.file_size_ = offset;
+  return index;
+}
+}  // namespace io
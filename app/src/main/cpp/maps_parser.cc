@@ -6,7 +6,6 @@
 #include <cerrno>
 #include <concepts>
 #include <cstdio>
-#include <cstdlib>
 #include <cstring>
 
 #include "linux_syscall_support.h"
@@ -124,7 +123,9 @@ auto ParseVmaEntry(FileReader<Buffer>& reader, uint32_t query_flags) -> std::opt
     auto vma_offset = FastParseHex<uint64_t>(&current);
     auto dev_major = FastParseHex<uint32_t>(&current);
     auto dev_minor = FastParseHex<uint32_t>(&current);
-    auto inode = static_cast<uint64_t>(strtoull(current, const_cast<char**>(&current), 10));
+    auto line_end = line->data() + line->size();
+    auto [inode, inode_digits] = internal::ParseDecimal(current, current < line_end ? line_end - current : 0);
+    current += inode_digits;
 
     auto name_offset = static_cast<size_t>(current - line->data() + 1);
 #ifdef __LP64__
@@ -175,12 +176,16 @@ MapsParser::MapsParser(uint32_t query_flags) : maps_reader_{"/proc/self/maps"} {
   auto query = reinterpret_cast<procmap_query*>(query_buffer_.data());
   query->size = sizeof(procmap_query);
   query->query_flags = query_flags | PROCMAP_QUERY_COVERING_OR_NEXT_VMA;
-  query->vma_name_addr = reinterpret_cast<uintptr_t>(name_buffer_.data());
+  BindNameBuffer();
 
   static_assert(sizeof(name_buffer_) == PATH_MAX);
   static_assert(sizeof(query_buffer_) == sizeof(procmap_query));
 }
 
+void MapsParser::BindNameBuffer() {
+  reinterpret_cast<procmap_query*>(query_buffer_.data())->vma_name_addr = reinterpret_cast<uintptr_t>(name_buffer_.data());
+}
+
 auto MapsParser::NextEntry() -> std::optional<VmaEntry> {
   if (status_ == Status::kCompleted) [[unlikely]] {
     return {};
@@ -241,21 +246,27 @@ auto SMapsParser::NextEntry() -> std::optional<SVmaEntry> {
     return {};
   }
 
+  // The views of the previous entry expire here; the lines of this one stay in place until the next call.
+  smaps_reader_.Unpin();
   smaps_reader_.Reduce();
+  smaps_reader_.Pin();
 
   while (auto vma = ParseVmaEntry(smaps_reader_, 0)) {
     if (query_flags_ != 0 && ((query_flags_ & kVmaAllFlags) != vma->vma_flags ||
                               (query_flags_ & kVmaQueryFileBackedVma && (vma->name.empty() || vma->name[0] != '/')))) {
+      smaps_reader_.Unpin();
       while (auto line = smaps_reader_.NextLine()) {
         if (line->starts_with("VmFlags:")) break;
       }
       smaps_reader_.Reduce();
+      smaps_reader_.Pin();
       continue;
     }
-    SVmaEntry entry{.base = *vma};
+    SVmaEntry entry{.base = *vma, .fields = {}, .values = {}, .vm_flags = {}};
     while (auto field = smaps_reader_.NextLine()) {
       if (field->starts_with("VmFlags:")) [[unlikely]] {
         entry.vm_flags = std::move(*field);
+        entry.values.AddAll(entry.fields);
         return entry;
       } else {
         entry.fields.emplace_back(std::move(*field));
@@ -335,32 +346,13 @@ auto VmaEntry::get_line(std::span<char> buffer) const -> std::string_view {
 }
 
 auto SVmaEntry::get_field(std::string_view name) const -> std::optional<size_t> {
-  auto field = get_field_string(name);
-  if (!field.empty()) {
-    auto begin = field.data();
-    auto end = begin + field.size();
-
-    auto tmp = const_cast<char*>(begin);
-    auto value = strtoul(begin, &tmp, 10);
-
-    if (tmp != begin && tmp <= end && (tmp == end || *tmp == ' ')) [[likely]] {
-      return static_cast<size_t>(value);
-    }
+  if (auto value = values.get(name)) [[likely]] {
+    return static_cast<size_t>(*value);
   }
   return {};
 }
 
-auto SVmaEntry::get_field_string(std::string_view name) const -> std::string_view {
-  for (const auto& field : fields) {
-    if (!field.starts_with(name)) continue;
-    if (name.size() == field.size() || field[name.size()] != ':') continue;
-    for (auto data = field.data() + name.size() + 1, end = field.data() + field.size(); data < end; ++data) {
-      if (*data == ' ') continue;
-      return {data, end};
-    }
-  }
-  return {};
-}
+auto SVmaEntry::get_field_string(std::string_view name) const -> std::string_view { return values.get_string(name); }
 
 auto SVmaEntry::has_vm_flag(std::string_view vm_flag) const -> bool {
   if (vm_flags.size() <= 9 /* "VmFlags: " */) [[unlikely]] {
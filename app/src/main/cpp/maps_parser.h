@@ -7,7 +7,9 @@
 #include <string_view>
 #include <vector>
 
+#include "buffer_pool.h"
 #include "file_reader.h"
+#include "key_value_reader.h"
 
 namespace io::proc {
 static constexpr uint32_t kVmaRead = 0x01;
@@ -45,7 +47,9 @@ class MapsParser {
       : maps_reader_{std::move(other.maps_reader_)},
         status_{other.status_},
         name_buffer_{other.name_buffer_},
-        query_buffer_{other.query_buffer_} {}
+        query_buffer_{other.query_buffer_} {
+    BindNameBuffer();
+  }
 
   auto operator=(MapsParser&& other) noexcept -> auto& {
     if (this != &other) {
@@ -53,6 +57,7 @@ class MapsParser {
       status_ = other.status_;
       name_buffer_ = other.name_buffer_;
       query_buffer_ = other.query_buffer_;
+      BindNameBuffer();
     }
     return *this;
   }
@@ -78,16 +83,27 @@ class MapsParser {
     kCompleted,
   };
 
-  FileReader<DefaultHeapBuffer> maps_reader_;
+  // Points the ioctl query at this object's name buffer; the copied query still names the old one.
+  void BindNameBuffer();
+
+  FileReader<DefaultPooledBuffer> maps_reader_;
   Status status_{Status::kTryIoctl};
 
   std::array<char, 0x1000> name_buffer_{};
   std::array<uint64_t, 13> query_buffer_{};
 };
 
+// The fields of a VMA in /proc/self/smaps, the one list of them; Field names them from here.
+using SMapsKeys = KeySet<"Size", "KernelPageSize", "MMUPageSize", "Rss", "Pss", "Pss_Dirty", "Shared_Clean",
+                         "Shared_Dirty", "Private_Clean", "Private_Dirty", "Referenced", "Anonymous", "LazyFree",
+                         "AnonHugePages", "ShmemPmdMapped", "FilePmdMapped", "Shared_Hugetlb", "Private_Hugetlb",
+                         "KSM", "Swap", "SwapPss", "Locked", "THPeligible", "ProtectionKey">;
+
 struct SVmaEntry {
   VmaEntry base;
   std::vector<std::string_view> fields;
+  // The same fields, parsed; `values.get<"Rss">()` resolves the key at compile time.
+  KeyValues<SMapsKeys> values;
   std::string_view vm_flags;
 
   [[nodiscard]] auto get_field(std::string_view name) const -> std::optional<size_t>;
@@ -109,12 +125,13 @@ class SMapsParser {
   explicit SMapsParser(uint32_t query_flags = 0);
 
   SMapsParser(SMapsParser&& other) noexcept
-      : smaps_reader_{std::move(other.smaps_reader_)}, query_flags_{other.query_flags_} {}
+      : smaps_reader_{std::move(other.smaps_reader_)}, query_flags_{other.query_flags_}, completed_{other.completed_} {}
 
   auto operator=(SMapsParser&& other) noexcept -> auto& {
     if (this != &other) {
       smaps_reader_ = std::move(other.smaps_reader_);
       query_flags_ = other.query_flags_;
+      completed_ = other.completed_;
     }
     return *this;
   }
@@ -134,34 +151,36 @@ class SMapsParser {
   auto NextEntry() -> std::optional<SVmaEntry>;
 
  private:
-  FileReader<DefaultHeapBuffer> smaps_reader_;
+  FileReader<DefaultPooledBuffer> smaps_reader_;
   uint32_t query_flags_;
   bool completed_;
 };
 
 struct Field {
-  static constexpr std::string_view kSize = "Size";
-  static constexpr std::string_view kKernelPageSize = "KernelPageSize";
-  static constexpr std::string_view kMMUPageSize = "MMUPageSize";
-  static constexpr std::string_view kRss = "Rss";
-  static constexpr std::string_view kPss = "Pss";
-  static constexpr std::string_view kPssDirty = "Pss_Dirty";
-  static constexpr std::string_view kSharedClean = "Shared_Clean";
-  static constexpr std::string_view kSharedDirty = "Shared_Dirty";
-  static constexpr std::string_view kPrivateClean = "Private_Clean";
-  static constexpr std::string_view kPrivateDirty = "Private_Dirty";
-  static constexpr std::string_view kReferenced = "Referenced";
-  static constexpr std::string_view kAnonymous = "Anonymous";
-  static constexpr std::string_view kLazyFree = "LazyFree";
-  static constexpr std::string_view kAnonHugePages = "AnonHugePages";
-  static constexpr std::string_view kShmemPmdMapped = "ShmemPmdMapped";
-  static constexpr std::string_view kFilePmdMapped = "FilePmdMapped";
-  static constexpr std::string_view kSharedHugetlb = "Shared_Hugetlb";
-  static constexpr std::string_view kPrivateHugetlb = "Private_Hugetlb";
-  static constexpr std::string_view kSwap = "Swap";
-  static constexpr std::string_view kSwapPss = "SwapPss";
-  static constexpr std::string_view kLocked = "Locked";
-  static constexpr std::string_view kTHPeligible = "THPeligible";
+  static constexpr std::string_view kSize = SMapsKeys::kName<"Size">;
+  static constexpr std::string_view kKernelPageSize = SMapsKeys::kName<"KernelPageSize">;
+  static constexpr std::string_view kMMUPageSize = SMapsKeys::kName<"MMUPageSize">;
+  static constexpr std::string_view kRss = SMapsKeys::kName<"Rss">;
+  static constexpr std::string_view kPss = SMapsKeys::kName<"Pss">;
+  static constexpr std::string_view kPssDirty = SMapsKeys::kName<"Pss_Dirty">;
+  static constexpr std::string_view kSharedClean = SMapsKeys::kName<"Shared_Clean">;
+  static constexpr std::string_view kSharedDirty = SMapsKeys::kName<"Shared_Dirty">;
+  static constexpr std::string_view kPrivateClean = SMapsKeys::kName<"Private_Clean">;
+  static constexpr std::string_view kPrivateDirty = SMapsKeys::kName<"Private_Dirty">;
+  static constexpr std::string_view kReferenced = SMapsKeys::kName<"Referenced">;
+  static constexpr std::string_view kAnonymous = SMapsKeys::kName<"Anonymous">;
+  static constexpr std::string_view kLazyFree = SMapsKeys::kName<"LazyFree">;
+  static constexpr std::string_view kKSM = SMapsKeys::kName<"KSM">;
+  static constexpr std::string_view kAnonHugePages = SMapsKeys::kName<"AnonHugePages">;
+  static constexpr std::string_view kShmemPmdMapped = SMapsKeys::kName<"ShmemPmdMapped">;
+  static constexpr std::string_view kFilePmdMapped = SMapsKeys::kName<"FilePmdMapped">;
+  static constexpr std::string_view kSharedHugetlb = SMapsKeys::kName<"Shared_Hugetlb">;
+  static constexpr std::string_view kPrivateHugetlb = SMapsKeys::kName<"Private_Hugetlb">;
+  static constexpr std::string_view kSwap = SMapsKeys::kName<"Swap">;
+  static constexpr std::string_view kSwapPss = SMapsKeys::kName<"SwapPss">;
+  static constexpr std::string_view kLocked = SMapsKeys::kName<"Locked">;
+  static constexpr std::string_view kTHPeligible = SMapsKeys::kName<"THPeligible">;
+  static constexpr std::string_view kProtectionKey = SMapsKeys::kName<"ProtectionKey">;
 };
 
 struct VmFlag {
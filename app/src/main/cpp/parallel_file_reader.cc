@@ -0,0 +1,108 @@
+#include "parallel_file_reader.h"
+
+#include <algorithm>
+
+namespace io::internal {
+namespace {
+constexpr auto Pack(uint64_t front, uint64_t back) -> uint64_t { return front << 32 | back; }
+constexpr auto Front(uint64_t range) -> uint64_t { return range >> 32; }
+constexpr auto Back(uint64_t range) -> uint64_t { return range & 0xffffffff; }
+}  // namespace
+
+WorkStealingPool::WorkStealingPool(unsigned workers)
+    : workers_{std::max(workers, 1U)}, slices_{std::make_unique<Slice[]>(workers_)} {}
+
+WorkStealingPool::~WorkStealingPool() {
+  {
+    std::lock_guard lock{mutex_};
+    stop_ = true;
+  }
+  start_.notify_all();
+  for (auto& thread : threads_) thread.join();
+}
+
+void WorkStealingPool::Run(size_t tasks, Task task, void* context) {
+  if (tasks == 0) [[unlikely]] {
+    return;
+  }
+
+  auto workers = static_cast<unsigned>(std::min<size_t>(workers_, tasks));
+  for (unsigned i = 0; i < workers_; ++i) {
+    auto front = i < workers ? tasks * i / workers : 0;
+    auto back = i < workers ? tasks * (i + 1) / workers : 0;
+    slices_[i].range.store(Pack(front, back), std::memory_order_relaxed);
+  }
+
+  if (workers > 1) {
+    std::lock_guard lock{mutex_};
+    // A new thread starts waiting from the current generation, so it takes part in this run.
+    while (threads_.size() + 1 < workers) {
+      auto worker = static_cast<unsigned>(threads_.size() + 1);
+      threads_.emplace_back([this, worker, generation = generation_] { Park(worker, generation); });
+    }
+    task_ = task;
+    context_ = context;
+    active_ = workers;
+    running_ = workers - 1;
+    ++generation_;
+    start_.notify_all();
+  }
+
+  Work(0, task, context);
+
+  if (workers > 1) {
+    std::unique_lock lock{mutex_};
+    done_.wait(lock, [this] { return running_ == 0; });
+  }
+}
+
+void WorkStealingPool::Park(unsigned worker, uint64_t generation) {
+  std::unique_lock lock{mutex_};
+  for (;;) {
+    start_.wait(lock, [&] { return stop_ || generation_ != generation; });
+    if (stop_) return;
+    generation = generation_;
+    // Runs with fewer tasks than workers leave the rest parked.
+    if (worker >= active_) continue;
+
+    auto task = task_;
+    auto context = context_;
+    lock.unlock();
+    Work(worker, task, context);
+    lock.lock();
+    if (--running_ == 0) done_.notify_one();
+  }
+}
+
+auto WorkStealingPool::PopFront(unsigned worker) -> std::optional<size_t> {
+  auto& range = slices_[worker].range;
+  for (auto current = range.load(std::memory_order_relaxed); Front(current) < Back(current);) {
+    if (range.compare_exchange_weak(current, Pack(Front(current) + 1, Back(current)), std::memory_order_relaxed)) {
+      return Front(current);
+    }
+  }
+  return {};
+}
+
+auto WorkStealingPool::StealBack(unsigned thief) -> std::optional<size_t> {
+  for (unsigned i = 1; i < workers_; ++i) {
+    auto& range = slices_[(thief + i) % workers_].range;
+    for (auto current = range.load(std::memory_order_relaxed); Front(current) < Back(current);) {
+      if (range.compare_exchange_weak(current, Pack(Front(current), Back(current) - 1), std::memory_order_relaxed)) {
+        return Back(current) - 1;
+      }
+    }
+  }
+  return {};
+}
+
+void WorkStealingPool::Work(unsigned worker, Task task, void* context) {
+  for (;;) {
+    auto next = PopFront(worker);
+    if (!next) next = StealBack(worker);
+    // Slices only ever shrink, so once every one of them is empty there is nothing left to do.
+    if (!next) return;
+    task(context, *next, worker);
+  }
+}
+}  // namespace io::internal
@@ -0,0 +1,259 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <concepts>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "file_reader.h"
+
+namespace io {
+namespace internal {
+/**
+ * Runs a fixed set of tasks, numbered [0, tasks), on a few threads. Every worker starts with a
+ * contiguous slice of the task indices and takes work from its front; a worker that runs dry
+ * steals from the back of the others' slices. A slice is a single 64-bit word (front, back), so
+ * both ends are claimed with one compare-and-swap and no locks are taken.
+ *
+ * The helper threads are started by the first run that needs them and parked on a condition
+ * variable between runs, so later runs only pay for a wake-up.
+ */
+class WorkStealingPool {
+ public:
+  using Task = void (*)(void* context, size_t task, unsigned worker);
+
+  explicit WorkStealingPool(unsigned workers);
+
+  ~WorkStealingPool();
+
+  WorkStealingPool(const WorkStealingPool&) = delete;
+  void operator=(const WorkStealingPool&) = delete;
+
+  [[nodiscard]] auto workers() const noexcept { return workers_; }
+
+  // Runs `task` once for every index and returns after all of them have finished. The calling
+  // thread takes part as worker 0.
+  void Run(size_t tasks, Task task, void* context);
+
+  template <typename F>
+    requires std::invocable<F&, size_t, unsigned>
+  void Run(size_t tasks, F&& func) {
+    Run(
+        tasks,
+        [](void* context, size_t task, unsigned worker) { (*static_cast<std::remove_reference_t<F>*>(context))(task, worker); },
+        &func);
+  }
+
+ private:
+  struct alignas(64) Slice {
+    std::atomic<uint64_t> range;
+  };
+
+  auto PopFront(unsigned worker) -> std::optional<size_t>;
+  auto StealBack(unsigned thief) -> std::optional<size_t>;
+  void Work(unsigned worker, Task task, void* context);
+  // Body of helper thread `worker`: waits for runs after `generation` and takes part in them.
+  void Park(unsigned worker, uint64_t generation);
+
+  unsigned workers_;
+  std::unique_ptr<Slice[]> slices_;
+
+  // Threads of workers 1 to threads_.size(); worker 0 is whichever thread calls Run.
+  std::vector<std::thread> threads_;
+  std::mutex mutex_;
+  std::condition_variable start_;
+  std::condition_variable done_;
+  // The fields below are guarded by mutex_ and describe the current run.
+  uint64_t generation_{};
+  unsigned active_{};
+  unsigned running_{};
+  Task task_{};
+  void* context_{};
+  bool stop_{};
+};
+}  // namespace internal
+
+/**
+ * @brief Splits a large regular file into byte ranges and runs a per-line callback on several threads.
+ *
+ * The file is mapped read-only and cut into a few ranges per thread. Every range is snapped to
+ * the first delimiter after its nominal start, so each line belongs to exactly one range and is
+ * never split; lines are then cut out with the same splitter FileReader uses. Ranges are handed
+ * out by a small work-stealing pool, so a thread stuck on a dense range does not hold the others up.
+ * The pool's threads live as long as the reader, so calling ForEachLine again starts none.
+ *
+ * The callback receives the line and, optionally, the index of the worker running it, which is
+ * below `workers()` and can index per-thread accumulators without any locking.
+ *
+ * @tparam kDelimiter Same as FileReader.
+ *
+ * @code
+ * auto reader = ParallelFileReader<>{"/data/local/tmp/smaps.txt"};
+ * std::vector<size_t> rss(reader.workers());
+ * reader.ForEachLine([&](std::string_view line, unsigned worker) {
+ *   if (line.starts_with("Rss:")) rss[worker] += ParseKb(line);
+ * });
+ * @endcode
+ *
+ * @note Lines are not delivered in file order. Files that cannot be mapped (procfs, pipes) are
+ * read sequentially on the calling thread through a FileReader, as worker 0.
+ * @warning The callback runs concurrently and must be thread-safe; the views stay valid until the
+ * reader is destroyed.
+ */
+template <internal::FixedString kDelimiter = UTF8::LF>
+class ParallelFileReader {
+ public:
+  using char_type = decltype(kDelimiter)::value_type;
+  using string_view_type = std::basic_string_view<char_type>;
+
+  explicit ParallelFileReader(int fd, unsigned threads = 0) : ParallelFileReader{fd, false, threads} {}
+
+  explicit ParallelFileReader(const char* pathname, unsigned threads = 0)
+      : ParallelFileReader{raw_open(pathname, O_RDONLY | O_CLOEXEC), true, threads} {}
+
+  ParallelFileReader(int dirfd, const char* pathname, unsigned threads = 0)
+      : ParallelFileReader{raw_openat(dirfd, pathname, O_RDONLY | O_CLOEXEC), true, threads} {}
+
+  ParallelFileReader(const ParallelFileReader&) = delete;
+  void operator=(const ParallelFileReader&) = delete;
+
+  ~ParallelFileReader() {
+    if (map_) raw_munmap(const_cast<uint8_t*>(map_), map_size_);
+    if (fd_ >= 0 && owned_) raw_close(fd_);
+  }
+
+  operator bool() const noexcept { return IsValid(); }
+
+  [[nodiscard]] auto IsValid() const noexcept { return fd_ >= 0; }
+  [[nodiscard]] auto IsMapped() const noexcept { return map_ != nullptr; }
+  [[nodiscard]] auto GetFd() const noexcept { return fd_; }
+  [[nodiscard]] auto workers() const noexcept { return pool_.workers(); }
+
+  /**
+   * Invokes `func` for every line of the file and returns the number of lines. Can be called
+   * more than once; every call reads the whole file again.
+   */
+  template <typename F>
+    requires std::invocable<F&, string_view_type, unsigned> || std::invocable<F&, string_view_type>
+  auto ForEachLine(F&& func) -> size_t {
+    auto invoke = [&func] [[gnu::always_inline]] (string_view_type line, unsigned worker) {
+      if constexpr (std::invocable<F&, string_view_type, unsigned>) {
+        func(line, worker);
+      } else {
+        func(line);
+      }
+    };
+
+    if (!map_) [[unlikely]] {
+      return ForEachLineSequential(invoke);
+    }
+
+    auto ranges = RangeCount();
+    std::atomic<size_t> lines{};
+    pool_.Run(ranges, [&](size_t range, unsigned worker) {
+      auto begin = Snap(NominalStart(range, ranges));
+      auto end = Snap(NominalStart(range + 1, ranges));
+      size_t count = 0;
+      while (begin < end) {
+        auto res = Splitter::Split(map_ + begin, end - begin);
+        if (!res) [[unlikely]] {
+          // Only the last range can end without a delimiter.
+          if (auto tail = Splitter::Tail(map_ + begin, end - begin)) {
+            invoke(*tail, worker);
+            ++count;
+          }
+          break;
+        }
+        invoke(res->first, worker);
+        begin += res->second;
+        ++count;
+      }
+      lines.fetch_add(count, std::memory_order_relaxed);
+    });
+    return lines.load(std::memory_order_relaxed);
+  }
+
+ private:
+  using Splitter = internal::LineSplitter<kDelimiter>;
+
+  // Ranges smaller than this are not worth a task of their own.
+  static constexpr size_t kMinRangeSize = 256 * 1024;
+  static constexpr size_t kRangesPerWorker = 4;
+
+  ParallelFileReader(int fd, bool owned, unsigned threads)
+      : fd_{fd}, owned_{owned}, pool_{threads ? threads : std::max(std::thread::hardware_concurrency(), 1U)} {
+    if (fd_ < 0) [[unlikely]] {
+      return;
+    }
+
+    auto offset = start_offset_ = raw_lseek(fd_, 0, SEEK_CUR);
+    auto size = offset < 0 ? offset : raw_lseek(fd_, 0, SEEK_END);
+    if (offset < 0 || size <= offset) [[unlikely]] {
+      // Streams and pseudo files: leave them to ForEachLineSequential.
+      if (offset >= 0) raw_lseek(fd_, offset, SEEK_SET);
+      return;
+    }
+    raw_lseek(fd_, offset, SEEK_SET);
+
+    auto map = raw_mmap(nullptr, static_cast<size_t>(size), PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (reinterpret_cast<uintptr_t>(map) < -4095UL) [[likely]] {
+      raw_madvise(map, static_cast<size_t>(size), MADV_SEQUENTIAL);
+      map_ = static_cast<const uint8_t*>(map);
+      map_size_ = static_cast<size_t>(size);
+      map_start_ = static_cast<size_t>(offset);
+    }
+  }
+
+  auto RangeCount() const -> size_t {
+    auto bytes = map_size_ - map_start_;
+    return std::clamp<size_t>(bytes / kMinRangeSize, 1, size_t{pool_.workers()} * kRangesPerWorker);
+  }
+
+  auto NominalStart(size_t range, size_t ranges) const -> size_t {
+    if (range == ranges) return map_size_;
+    auto bytes = map_size_ - map_start_;
+    return map_start_ + internal::AlignDown<char_type>(bytes / ranges * range);
+  }
+
+  // Moves a nominal range boundary past the next delimiter. Neighbouring ranges snap the same
+  // boundary, so every line is read by exactly one of them.
+  auto Snap(size_t pos) const -> size_t {
+    if (pos == map_start_) return pos;
+    if (pos >= map_size_ || map_size_ - pos < sizeof(char_type)) return map_size_;
+    if (auto res = Splitter::Split(map_ + pos, map_size_ - pos)) [[likely]] {
+      return pos + res->second;
+    }
+    return map_size_;
+  }
+
+  auto ForEachLineSequential(auto& invoke) -> size_t {
+    if (fd_ < 0) [[unlikely]] {
+      return 0;
+    }
+    // Pseudo files are seekable; rewind them so that every call sees the whole file.
+    if (start_offset_ >= 0) raw_lseek(fd_, start_offset_, SEEK_SET);
+    size_t count = 0;
+    for (auto line : FileReader<DefaultHeapBuffer, kDelimiter>{fd_}) {
+      invoke(line, 0);
+      ++count;
+    }
+    return count;
+  }
+
+  int fd_;
+  bool owned_;
+  const uint8_t* map_{};
+  size_t map_size_{};
+  size_t map_start_{};
+  int64_t start_offset_{-1};
+  internal::WorkStealingPool pool_;
+};
+}  // namespace io
@@ -0,0 +1,340 @@
+#pragma once
+
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "file_reader.h"
+
+namespace io {
+/**
+ * Field types for RecordReader schemas. A field either produces a value (`value_type`) or only
+ * moves the cursor. Every field parses straight from the line, no token is split out first.
+ */
+namespace record {
+namespace internal {
+// Marks the end of the schema for fields that look at their successor.
+struct End {};
+
+inline auto IsBlank(char c) { return c == ' ' || c == '\t'; }
+
+// Where a Str or Skip field followed by `Next` ends.
+template <typename Next>
+auto FindTerminator(const char* p, const char* end) -> const char*;
+}  // namespace internal
+
+// Hexadecimal number without prefix, either case. At least one digit is required.
+template <std::unsigned_integral T = uint64_t>
+struct Hex {
+  using value_type = T;
+
+  template <typename Next>
+  [[gnu::always_inline]] static auto Parse(const char*& p, const char* end, value_type& out) -> bool {
+    auto s = p;
+    T value{};
+    for (; s < end; ++s) {
+      auto c = static_cast<unsigned char>(*s);
+      T digit;
+      if (c >= '0' && c <= '9') {
+        digit = static_cast<T>(c - '0');
+      } else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f') {
+        digit = static_cast<T>((c | 0x20) - 'a') + T{10};
+      } else {
+        break;
+      }
+      value = (value << 4) | digit;
+    }
+    if (s == p) [[unlikely]] {
+      return false;
+    }
+    p = s;
+    out = value;
+    return true;
+  }
+};
+
+// Decimal number; signed types accept a leading '-'. At least one digit is required.
+template <std::integral T = uint64_t>
+struct Dec {
+  using value_type = T;
+
+  template <typename Next>
+  [[gnu::always_inline]] static auto Parse(const char*& p, const char* end, value_type& out) -> bool {
+    auto s = p;
+    auto negative = false;
+    if constexpr (std::is_signed_v<T>) {
+      if (s < end && *s == '-') {
+        negative = true;
+        ++s;
+      }
+    }
+    auto digits = s;
+    std::make_unsigned_t<T> value{};
+    for (; s < end && static_cast<unsigned char>(*s - '0') < 10; ++s) {
+      value = value * 10 + static_cast<unsigned char>(*s - '0');
+    }
+    if (s == digits) [[unlikely]] {
+      return false;
+    }
+    p = s;
+    out = static_cast<T>(negative ? 0 - value : value);
+    return true;
+  }
+};
+
+// Fixed-width flag characters such as "rwxp": bit i is set if character i equals kFlags[i].
+template <::io::internal::FixedString kFlags>
+  requires(std::is_same_v<typename decltype(kFlags)::value_type, char> && kFlags.size() <= 32)
+struct Flags {
+  using value_type = uint32_t;
+
+  template <typename Next>
+  [[gnu::always_inline]] static auto Parse(const char*& p, const char* end, value_type& out) -> bool {
+    if (static_cast<size_t>(end - p) < kFlags.size()) [[unlikely]] {
+      return false;
+    }
+    out = [&]<size_t... I>(std::index_sequence<I...>) {
+      return ((static_cast<uint32_t>(p[I] == kFlags[I]) << I) | ...);
+    }(std::make_index_sequence<kFlags.size()>{});
+    p += kFlags.size();
+    return true;
+  }
+};
+
+// A single character.
+struct Char {
+  using value_type = char;
+
+  template <typename Next>
+  [[gnu::always_inline]] static auto Parse(const char*& p, const char* end, value_type& out) -> bool {
+    if (p == end) [[unlikely]] {
+      return false;
+    }
+    out = *p++;
+    return true;
+  }
+};
+
+// Text up to the start of the next field, which must be a separator (Lit or Space), or up to the
+// end of the line if this is the last field.
+struct Str {
+  using value_type = std::string_view;
+
+  template <typename Next>
+  [[gnu::always_inline]] static auto Parse(const char*& p, const char* end, value_type& out) -> bool {
+    auto stop = internal::FindTerminator<Next>(p, end);
+    out = {p, stop};
+    p = stop;
+    return true;
+  }
+};
+
+// Everything left on the line, with leading blanks removed.
+struct Rest {
+  using value_type = std::string_view;
+
+  template <typename Next>
+    requires std::is_same_v<Next, internal::End>
+  [[gnu::always_inline]] static auto Parse(const char*& p, const char* end, value_type& out) -> bool {
+    while (p < end && internal::IsBlank(*p)) ++p;
+    out = {p, end};
+    p = end;
+    return true;
+  }
+};
+
+// A field that is not needed; ends like Str.
+struct Skip {
+  template <typename Next>
+  [[gnu::always_inline]] static auto Parse(const char*& p, const char* end) -> bool {
+    p = internal::FindTerminator<Next>(p, end);
+    return true;
+  }
+};
+
+// Literal text that must be present, e.g. Lit<":">.
+template <::io::internal::FixedString kText>
+  requires(std::is_same_v<typename decltype(kText)::value_type, char> && !kText.empty())
+struct Lit {
+  template <typename Next>
+  [[gnu::always_inline]] static auto Parse(const char*& p, const char* end) -> bool {
+    if (static_cast<size_t>(end - p) < kText.size()) [[unlikely]] {
+      return false;
+    }
+    auto match = [&]<size_t... I>(std::index_sequence<I...>) {
+      return ((p[I] == kText[I]) && ...);
+    }(std::make_index_sequence<kText.size()>{});
+    if (!match) [[unlikely]] {
+      return false;
+    }
+    p += kText.size();
+    return true;
+  }
+
+  // First occurrence of the literal in [p, end), or `end`.
+  [[gnu::always_inline]] static auto Find(const char* p, const char* end) -> const char* {
+    const void* hit;
+    if constexpr (kText.size() == 1) {
+      hit = memchr(p, kText[0], static_cast<size_t>(end - p));
+    } else {
+      hit = memmem(p, static_cast<size_t>(end - p), kText.data_, kText.size());
+    }
+    return hit ? static_cast<const char*>(hit) : end;
+  }
+};
+
+// Any run of blanks, including none: the column padding of /proc/net/* and friends.
+struct Space {
+  template <typename Next>
+  [[gnu::always_inline]] static auto Parse(const char*& p, const char* end) -> bool {
+    while (p < end && internal::IsBlank(*p)) ++p;
+    return true;
+  }
+};
+
+namespace internal {
+template <typename T>
+inline constexpr bool kIsLit = false;
+
+template <::io::internal::FixedString kText>
+inline constexpr bool kIsLit<Lit<kText>> = true;
+
+template <typename Next>
+auto FindTerminator(const char* p, const char* end) -> const char* {
+  if constexpr (std::is_same_v<Next, End>) {
+    return end;
+  } else if constexpr (std::is_same_v<Next, Space>) {
+    while (p < end && !IsBlank(*p)) ++p;
+    return p;
+  } else {
+    static_assert(kIsLit<Next>, "Str and Skip must be followed by Lit, Space or the end of the schema");
+    return Next::Find(p, end);
+  }
+}
+
+template <typename Field>
+concept ValueField = requires { typename Field::value_type; };
+
+template <typename Field>
+struct ValueTuple {
+  using type = std::tuple<>;
+};
+
+template <ValueField Field>
+struct ValueTuple<Field> {
+  using type = std::tuple<typename Field::value_type>;
+};
+}  // namespace internal
+
+/**
+ * A line format: fields and separators in the order they appear. The parsed record is a tuple of
+ * the values of the value-producing fields, in order.
+ *
+ * @code
+ * // /proc/self/maps
+ * using Maps = Schema<Hex<uintptr_t>, Lit<"-">, Hex<uintptr_t>, Space, Flags<"rwxs">, Space, Hex<>, Space,
+ *                     Hex<uint32_t>, Lit<":">, Hex<uint32_t>, Space, Dec<>, Space, Rest>;
+ * auto [start, end, flags, offset, major, minor, inode, name] = *Maps::Parse(line);
+ * @endcode
+ */
+template <typename... Fields>
+  requires(sizeof...(Fields) > 0)
+struct Schema {
+  using value_type = decltype(std::tuple_cat(std::declval<typename internal::ValueTuple<Fields>::type>()...));
+
+  // Parses one line; returns nothing if it does not match. Trailing text is ignored.
+  [[gnu::always_inline]] static auto Parse(std::string_view line) -> std::optional<value_type> {
+    value_type out{};
+    auto p = line.data();
+    if (!ParseFields<0, 0>(p, line.data() + line.size(), out)) [[unlikely]] {
+      return {};
+    }
+    return out;
+  }
+
+ private:
+  template <size_t I>
+  using FieldAt = std::tuple_element_t<I, std::tuple<Fields..., internal::End>>;
+
+  template <size_t I, size_t J>
+  [[gnu::always_inline]] static auto ParseFields(const char*& p, const char* end, value_type& out) -> bool {
+    if constexpr (I == sizeof...(Fields)) {
+      return true;
+    } else {
+      using Field = FieldAt<I>;
+      using Next = FieldAt<I + 1>;
+      if constexpr (internal::ValueField<Field>) {
+        return Field::template Parse<Next>(p, end, std::get<J>(out)) && ParseFields<I + 1, J + 1>(p, end, out);
+      } else {
+        return Field::template Parse<Next>(p, end) && ParseFields<I + 1, J>(p, end, out);
+      }
+    }
+  }
+};
+}  // namespace record
+
+/**
+ * @brief Reads a delimited text file as typed records described by a record::Schema.
+ *
+ * Each line is parsed in a single left-to-right pass into `Schema::value_type`, a std::tuple, with
+ * the same speed as a hand-written parser. Lines that do not match the schema (headers, blank
+ * lines) are skipped and counted.
+ *
+ * @code
+ * using namespace io::record;
+ * // /proc/net/tcp: "  sl  local_address rem_address   st ..."
+ * using Tcp = Schema<Space, Dec<>, Lit<":">, Space, Hex<uint32_t>, Lit<":">, Hex<uint16_t>, Space,
+ *                    Hex<uint32_t>, Lit<":">, Hex<uint16_t>, Space, Hex<uint8_t>>;
+ * for (auto [sl, local_ip, local_port, remote_ip, remote_port, state] : RecordReader<Tcp>{"/proc/net/tcp"}) {}
+ * @endcode
+ *
+ * @note Str stops at the first occurrence of the separator that follows it, so a field that may
+ * contain its own separator (the comm of /proc/<pid>/stat) has to be the last one or be parsed by hand.
+ * @warning string_view fields point into the reader buffer and follow the FileReader lifetime rules.
+ */
+template <typename Schema, internal::BufferPolicy Buffer = DefaultBuffer, internal::FixedString kDelimiter = UTF8::LF>
+  requires std::is_same_v<typename decltype(kDelimiter)::value_type, char>
+class RecordReader {
+ public:
+  using value_type = Schema::value_type;
+  using iterator = internal::Iterator<RecordReader>;
+
+  explicit RecordReader(int fd) : reader_{fd} {}
+
+  explicit RecordReader(const char* pathname) : reader_{pathname} {}
+
+  RecordReader(int dirfd, const char* pathname) : reader_{dirfd, pathname} {}
+
+  operator bool() const noexcept { return IsValid(); }
+
+  auto operator++() { return NextRecord(); }
+  auto operator++(int) { return NextRecord(); }
+
+  [[nodiscard]] auto IsValid() const noexcept { return reader_.IsValid(); }
+  [[nodiscard]] auto GetFd() const noexcept { return reader_.GetFd(); }
+  // Lines skipped so far because they did not match the schema.
+  [[nodiscard]] auto skipped() const noexcept { return skipped_; }
+
+  [[nodiscard]] auto begin() { return iterator{this}; }
+  [[nodiscard]] auto end() { return iterator{}; }
+
+  auto NextRecord() -> std::optional<value_type> {
+    while (auto line = reader_.NextLine()) {
+      if (auto record = Schema::Parse(*line)) [[likely]] {
+        return record;
+      }
+      ++skipped_;
+    }
+    return {};
+  }
+
+ private:
+  FileReader<Buffer, kDelimiter> reader_;
+  size_t skipped_{};
+};
+}  // namespace io
@@ -0,0 +1,219 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include "file_reader.h"
+
+namespace io {
+/**
+ * @brief Reads the lines of a file last to first.
+ *
+ * Blocks are read with pread(2) backwards from the end of the file into the `Buffer` policy, so
+ * the most recent records of a large log or dump come out first and the rest of the file is never
+ * read if the loop stops early. Lines are split by the same `kDelimiter` as FileReader and come out
+ * in exactly the reverse order, delimiters excluded. After the first block, every read ends on a
+ * 4 KiB boundary of the file.
+ *
+ * The size is taken from fstat when the reader is created, so this suits regular files; procfs
+ * files report a size of 0 and read as empty.
+ *
+ * @code
+ * // The last 100 lines of a dump.
+ * auto reader = ReverseFileReader<DefaultHeapBuffer>{"/data/local/tmp/dump.txt"};
+ * for (auto i = 0; i < 100; ++i) {
+ *   auto line = reader.NextLine();
+ *   if (!line) break;
+ * }
+ * @endcode
+ *
+ * @note A line longer than the buffer is returned in pieces, last piece first. With a delimiter
+ * sequence whose end can overlap its start, the split may differ from FileReader.
+ *
+ * @warning The returned string_view points to the internal buffer and is invalidated by the next
+ * NextLine call.
+ */
+template <internal::BufferPolicy Buffer = DefaultBuffer, internal::FixedString kDelimiter = UTF8::LF>
+  requires(Buffer::size % sizeof(typename decltype(kDelimiter)::value_type) == 0 &&
+           !internal::GrowableBuffer<Buffer>)
+class ReverseFileReader {
+ public:
+  using char_type = decltype(kDelimiter)::value_type;
+  using string_view_type = std::basic_string_view<char_type>;
+  using value_type = string_view_type;
+  using iterator = internal::Iterator<ReverseFileReader>;
+
+  explicit ReverseFileReader(int fd) : ReverseFileReader{fd, false} {}
+
+  explicit ReverseFileReader(const char* pathname)
+      : ReverseFileReader{raw_open(pathname, O_RDONLY | O_CLOEXEC), true} {}
+
+  ReverseFileReader(int dirfd, const char* pathname)
+      : ReverseFileReader{raw_openat(dirfd, pathname, O_RDONLY | O_CLOEXEC), true} {}
+
+  ReverseFileReader(ReverseFileReader&& other) noexcept
+      : fd_{std::exchange(other.fd_, -1)},
+        owned_{std::exchange(other.owned_, false)},
+        started_{other.started_},
+        trailing_{other.trailing_},
+        done_{other.done_},
+        offset_{other.offset_},
+        begin_{other.begin_},
+        end_{other.end_},
+        buffer_{std::move(other.buffer_)} {}
+
+  auto operator=(ReverseFileReader&& other) noexcept -> auto& {
+    if (this != &other) {
+      if (fd_ >= 0 && owned_) raw_close(fd_);
+      fd_ = std::exchange(other.fd_, -1);
+      owned_ = std::exchange(other.owned_, false);
+      started_ = other.started_;
+      trailing_ = other.trailing_;
+      done_ = other.done_;
+      offset_ = other.offset_;
+      begin_ = other.begin_;
+      end_ = other.end_;
+      buffer_ = std::move(other.buffer_);
+    }
+    return *this;
+  }
+
+  ReverseFileReader(const ReverseFileReader&) = delete;
+  void operator=(const ReverseFileReader&) = delete;
+
+  ~ReverseFileReader() {
+    if (fd_ >= 0 && owned_) [[likely]] {
+      raw_close(fd_);
+    }
+  }
+
+  [[nodiscard]] auto IsValid() const noexcept { return fd_ >= 0; }
+  [[nodiscard]] auto GetFd() const noexcept { return fd_; }
+  operator bool() const noexcept { return IsValid(); }
+
+  auto operator++() { return NextLine(); }
+  auto operator++(int) { return NextLine(); }
+
+  [[nodiscard]] auto begin() { return iterator{this}; }
+  [[nodiscard]] auto end() { return iterator{}; }
+
+  auto NextLine() -> std::optional<string_view_type> {
+    if (done_ || fd_ < 0) [[unlikely]] {
+      return {};
+    }
+
+    if (!started_) [[unlikely]] {
+      started_ = true;
+      if (offset_ == 0 || !Fill()) {
+        done_ = true;
+        return {};
+      }
+      trailing_ = Splitter::EndsWithDelimiter(&buffer_[begin_], end_ - begin_);
+    }
+
+    for (;;) {
+      // The delimiter that ends this record was seen by the previous call, or at the end of the file.
+      auto size = end_ - begin_ - (trailing_ ? kDelimiterSize : 0);
+
+      if (auto start = Splitter::SplitLast(&buffer_[begin_], size)) [[likely]] {
+        auto record = View(begin_ + *start, size - *start);
+        end_ = begin_ + *start;
+        trailing_ = true;
+        return record;
+      }
+
+      if (offset_ == 0) {
+        // Everything left is the first record of the file.
+        done_ = true;
+        return View(begin_, size);
+      }
+
+      if (begin_ == 0 && end_ == kBufferSize) [[unlikely]] {
+        // A record that fills the whole buffer is passed on in pieces, as FileReader does.
+        auto record = View(0, size);
+        end_ = 0;
+        trailing_ = false;
+        return record;
+      }
+
+      if (!Fill()) [[unlikely]] {
+        done_ = true;
+        return {};
+      }
+    }
+  }
+
+ private:
+  using Splitter = internal::LineSplitter<kDelimiter>;
+
+  static constexpr size_t kBufferSize = Buffer::size;
+  static constexpr size_t kDelimiterSize = Splitter::kLength * sizeof(char_type);
+  static constexpr uint64_t kBlockAlignment = 4096;
+
+  ReverseFileReader(int fd, bool owned)
+      : fd_{fd}, owned_{owned}, buffer_{Buffer::template make_buffer<kBufferSize>()} {
+    if (fd_ < 0) [[unlikely]] {
+      return;
+    }
+    kernel_stat st;
+    if (auto r = raw_fstat(fd_, &st); r < 0) [[unlikely]] {
+      if (owned_) raw_close(fd_);
+      fd_ = r;
+      return;
+    }
+    // A trailing partial code unit is dropped, as FileReader drops it at the end of the input.
+    offset_ = internal::AlignDown<char_type>(static_cast<uint64_t>(st.st_size));
+  }
+
+  auto View(size_t pos, size_t size) -> string_view_type {
+    return string_view_type{reinterpret_cast<const char_type*>(&buffer_[pos]), size / sizeof(char_type)};
+  }
+
+  // Moves the unread data to the end of the buffer and reads the block before it in front of it.
+  auto Fill() -> bool {
+    auto size = end_ - begin_;
+    if (end_ != kBufferSize) {
+      memmove(&buffer_[kBufferSize - size], &buffer_[begin_], size);
+      begin_ = kBufferSize - size;
+      end_ = kBufferSize;
+    }
+
+    // Start on a block boundary when the space allows, so that only the first read is unaligned.
+    auto start = offset_ - std::min<uint64_t>(begin_, offset_);
+    if (auto aligned = (start + kBlockAlignment - 1) & ~(kBlockAlignment - 1); start != 0 && aligned < offset_) {
+      start = aligned;
+    }
+
+    auto count = static_cast<size_t>(offset_ - start);
+    auto dst = begin_ - count;
+    for (size_t done = 0; done < count;) {
+      auto n = raw_pread64(fd_, &buffer_[dst + done], count - done, static_cast<loff_t>(start + done));
+      if (n == -EINTR) continue;
+      // The file shrank or cannot be read; what is buffered no longer lines up with it.
+      if (n <= 0) [[unlikely]] {
+        return false;
+      }
+      done += static_cast<size_t>(n);
+    }
+    begin_ = dst;
+    offset_ = start;
+    return true;
+  }
+
+  int fd_;
+  bool owned_;
+  bool started_{};
+  // Whether the data before end_ ends with the delimiter of the record to return next.
+  bool trailing_{};
+  bool done_{};
+  // File offset of buffer_[begin_]; everything before it is still to be read.
+  uint64_t offset_{};
+  size_t begin_{kBufferSize};
+  size_t end_{kBufferSize};
+  Buffer::template type<kBufferSize> buffer_;
+};
+}  // namespace io
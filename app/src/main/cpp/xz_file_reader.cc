@@ -0,0 +1,101 @@
+#include "xz_file_reader.h"
+
+#include <cerrno>
+#include <cstdlib>
+
+#include "xdl.h"
+
+namespace io::internal {
+namespace {
+// LZMA SDK types, see 7zTypes.h and Xz.h.
+struct ISzAlloc {
+  void* (*Alloc)(const ISzAlloc* p, size_t size);
+  void (*Free)(const ISzAlloc* p, void* address);
+};
+
+constexpr int kFinishAny = 0;  // CODER_FINISH_ANY
+constexpr int kSzOk = 0;       // SZ_OK
+
+using CrcGenerateTable = void (*)();
+using Crc64GenerateTable = void (*)();
+using XzUnpackerConstruct = void (*)(void* p, const ISzAlloc* alloc);
+// The LZMA SDK 18 signature, with srcFinished, that every release since Android 10 ships.
+using XzUnpackerCode = int (*)(void* p, uint8_t* dest, size_t* dest_len, const uint8_t* src, size_t* src_len,
+                               int src_finished, int finish_mode, int* status);
+using XzUnpackerIsStreamWasFinished = int (*)(const void* p);
+using XzUnpackerFree = void (*)(void* p);
+
+// Where the unpacker lives differs between releases: liblzma, or statically linked into libunwindstack.
+constexpr const char* kLibraries[] = {"liblzma.so", "libunwindstack.so"};
+
+constexpr ISzAlloc kAllocator = {
+    .Alloc = [](const ISzAlloc*, size_t size) { return malloc(size); },
+    .Free = [](const ISzAlloc*, void* address) { free(address); },
+};
+
+struct XzUnpacker {
+  XzUnpackerConstruct construct;
+  XzUnpackerCode code;
+  XzUnpackerIsStreamWasFinished is_finished;
+  XzUnpackerFree free;
+
+  [[nodiscard]] auto IsValid() const { return construct && code && is_finished && free; }
+};
+
+auto Resolve(void* handle, const char* symbol) -> void* {
+  return xdl_sym(handle, symbol, nullptr) ?: xdl_dsym(handle, symbol, nullptr);
+}
+
+auto LoadUnpacker() -> XzUnpacker {
+  for (auto library : kLibraries) {
+    auto handle = xdl_open(library, XDL_TRY_FORCE_LOAD);
+    if (!handle) continue;
+
+    auto crc_generate = reinterpret_cast<CrcGenerateTable>(Resolve(handle, "CrcGenerateTable"));
+    auto crc64_generate = reinterpret_cast<Crc64GenerateTable>(Resolve(handle, "Crc64GenerateTable"));
+    auto unpacker = XzUnpacker{
+        .construct = reinterpret_cast<XzUnpackerConstruct>(Resolve(handle, "XzUnpacker_Construct")),
+        .code = reinterpret_cast<XzUnpackerCode>(Resolve(handle, "XzUnpacker_Code")),
+        .is_finished = reinterpret_cast<XzUnpackerIsStreamWasFinished>(Resolve(handle, "XzUnpacker_IsStreamWasFinished")),
+        .free = reinterpret_cast<XzUnpackerFree>(Resolve(handle, "XzUnpacker_Free")),
+    };
+    // The library stays loaded for the lifetime of the process, so the handle can go.
+    xdl_close(handle);
+
+    if (crc_generate && crc64_generate && unpacker.IsValid()) [[likely]] {
+      crc_generate();
+      crc64_generate();
+      return unpacker;
+    }
+  }
+  return {};
+}
+
+auto Unpacker() -> const XzUnpacker& {
+  static const auto unpacker = LoadUnpacker();
+  return unpacker;
+}
+}  // namespace
+
+XzDecoder::XzDecoder() {
+  auto& unpacker = Unpacker();
+  if (!unpacker.IsValid()) [[unlikely]] {
+    return;
+  }
+  state_ = std::make_unique<State>();
+  unpacker.construct(state_.get(), &kAllocator);
+}
+
+void XzDecoder::Release() {
+  if (state_) Unpacker().free(state_.get());
+  state_.reset();
+}
+
+auto XzDecoder::Decode(uint8_t* dst, size_t* dst_len, const uint8_t* src, size_t* src_len, bool src_finished) -> int {
+  int status;
+  auto res = Unpacker().code(state_.get(), dst, dst_len, src, src_len, src_finished, kFinishAny, &status);
+  return res == kSzOk ? 0 : -EIO;
+}
+
+auto XzDecoder::IsStreamFinished() const -> bool { return state_ && Unpacker().is_finished(state_.get()) != 0; }
+}  // namespace io::internal
@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <utility>
+
+#include "file_reader.h"
+
+namespace io {
+namespace internal {
+/**
+ * Streaming front end of the XZ unpacker (LZMA SDK) that Android ships in its system libraries,
+ * the same one xdl_lzma uses for .gnu_debugdata. The symbols are resolved once with xDL; when
+ * they cannot be found every decoder is invalid.
+ */
+class XzDecoder {
+ public:
+  XzDecoder();
+
+  XzDecoder(XzDecoder&& other) noexcept : state_{std::move(other.state_)} {}
+
+  auto operator=(XzDecoder&& other) noexcept -> XzDecoder& {
+    if (this != &other) {
+      Release();
+      state_ = std::move(other.state_);
+    }
+    return *this;
+  }
+
+  XzDecoder(const XzDecoder&) = delete;
+  void operator=(const XzDecoder&) = delete;
+
+  ~XzDecoder() { Release(); }
+
+  [[nodiscard]] auto IsValid() const noexcept { return state_ != nullptr; }
+
+  // Decodes from `src` into `dst`. On return `dst_len` and `src_len` hold the bytes produced and
+  // consumed. Returns 0, or -EIO on corrupt input.
+  auto Decode(uint8_t* dst, size_t* dst_len, const uint8_t* src, size_t* src_len, bool src_finished) -> int;
+
+  // Whether the last Decode reached the end of an xz stream.
+  [[nodiscard]] auto IsStreamFinished() const -> bool;
+
+ private:
+  // Opaque CXzUnpacker storage, large enough for every LZMA SDK version Android has shipped.
+  struct alignas(16) State {
+    uint8_t storage[4096];
+  };
+
+  void Release();
+
+  std::unique_ptr<State> state_;
+};
+}  // namespace internal
+
+/**
+ * @brief A FileReader over an `.xz` compressed file.
+ *
+ * The compressed input is read one buffer at a time and decoded straight into the reader buffer,
+ * so lines come out as from a FileReader without ever inflating the file to disk or to a heap blob.
+ * Memory stays bounded by two buffers of the `Buffer` policy (compressed and decoded) plus the
+ * decoder dictionary, whose size the xz stream declares (8 MiB with `xz -6`; choose a lower
+ * preset with `xz --lzma2=dict=...` for large dumps).
+ *
+ * Decoding is done by the system LZMA library through xDL. When it cannot be loaded, or the input
+ * is corrupt, the reader simply hits end of file; `IsValid()` is false if it could not start at all.
+ *
+ * @code
+ * for (auto line : XzFileReader<>{"/data/local/tmp/maps.txt.xz"}) {}
+ * @endcode
+ */
+template <internal::BufferPolicy Buffer = DefaultBuffer, internal::FixedString kDelimiter = UTF8::LF,
+          internal::StatsPolicy Stats = NoStats>
+  requires(Buffer::size % sizeof(typename decltype(kDelimiter)::value_type) == 0)
+class XzFileReader : public internal::BaseReader<XzFileReader<Buffer, kDelimiter, Stats>,
+                                                 std::basic_string_view<typename decltype(kDelimiter)::value_type>,
+                                                 Buffer,
+                                                 Stats> {
+ public:
+  using char_type = decltype(kDelimiter)::value_type;
+  using string_view_type = std::basic_string_view<char_type>;
+
+  explicit XzFileReader(int fd) : XzFileReader{fd, false} {}
+
+  explicit XzFileReader(const char* pathname) : XzFileReader{raw_open(pathname, O_RDONLY | O_CLOEXEC), true} {}
+
+  XzFileReader(int dirfd, const char* pathname)
+      : XzFileReader{raw_openat(dirfd, pathname, O_RDONLY | O_CLOEXEC), true} {}
+
+  [[nodiscard]] auto IsValid() const noexcept { return XzFileReader::BaseReader::IsValid() && decoder_.IsValid(); }
+
+  operator bool() const noexcept { return IsValid(); }
+
+  auto operator++() { return NextLine(); }
+
+  auto NextLine() -> std::optional<string_view_type> {
+    if (!decoder_.IsValid()) [[unlikely]] {
+      return {};
+    }
+    return this->NextImpl([] [[gnu::always_inline]] (const uint8_t* buf, size_t available, size_t& scanned) {
+      return Splitter::Split(buf, available, scanned);
+    });
+  }
+
+ private:
+  using Splitter = internal::LineSplitter<kDelimiter>;
+
+  static constexpr size_t kInputSize = Buffer::size;
+
+  XzFileReader(int fd, bool owned)
+      : XzFileReader::BaseReader{fd, owned}, input_{Buffer::template make_buffer<kInputSize>()} {}
+
+  static auto OnBufferFull(const uint8_t* buf, size_t sz) -> std::optional<string_view_type> {
+    return string_view_type{reinterpret_cast<const char_type*>(buf),
+                            reinterpret_cast<const char_type*>(buf + internal::AlignDown<char_type>(sz))};
+  }
+
+  static auto OnEOF(const uint8_t* buf, size_t sz) -> std::optional<string_view_type> { return Splitter::Tail(buf, sz); }
+
+  // Fills `buf` with decoded bytes, reading more compressed input whenever the decoder asks for it.
+  auto ReadFromFD(int fd, void* buf, size_t sz) -> ssize_t {
+    for (;;) {
+      if (in_pos_ == in_end_ && !in_eof_) {
+        auto n = raw_read(fd, &input_[0], kInputSize);
+        if (n < 0) [[unlikely]] {
+          return n;
+        }
+        in_pos_ = 0;
+        in_end_ = static_cast<size_t>(n);
+        in_eof_ = n == 0;
+      }
+
+      auto out_len = sz;
+      auto in_len = in_end_ - in_pos_;
+      if (decoder_.Decode(static_cast<uint8_t*>(buf), &out_len, &input_[in_pos_], &in_len, in_eof_) < 0) [[unlikely]] {
+        return -EIO;
+      }
+      in_pos_ += in_len;
+
+      if (out_len > 0) [[likely]] {
+        return static_cast<ssize_t>(out_len);
+      }
+      // Nothing decoded and nothing left to feed: either the stream ended or it is truncated.
+      if (in_eof_ && in_len == 0) [[unlikely]] {
+        return decoder_.IsStreamFinished() ? 0 : -EIO;
+      }
+    }
+  }
+
+  internal::XzDecoder decoder_;
+  Buffer::template type<kInputSize> input_;
+  size_t in_pos_{};
+  size_t in_end_{};
+  bool in_eof_{};
+
+  friend class XzFileReader::BaseReader;
+};
+}  // namespace io